@@ -12,11 +12,9 @@
 #include "./source/LM-NT.h"
 #include "./source/LM-random.h"
 #include "./source/Brutal-Search.h"
+#include "./source/regex_compiler.h"
+#include "./source/benchmark.h"
 using namespace std;
-bool compare(unsigned int a, unsigned int b)
-{
-return a>b;
-}
 
 int main(int argc, char* argv[])
 {
@@ -24,16 +22,30 @@ int main(int argc, char* argv[])
 	double benefit_threshold = 1.5;
 	unsigned int algorithm = atoi(argv[1]); 
 	string data_path = argv[2];
-	ifstream fin(data_path.c_str());
 	unsigned int days = atoi(argv[3]);
 	unsigned int hour = atoi(argv[4]);
 	unsigned int query_type = atoi(argv[5]);
-	unsigned int scores[4];
+	vector<unsigned int> scores(4, 0);
+	bool use_snapshot = false; // build a CSR snapshot of the successor lists at each window slide, enabled by appending --snapshot after the labels.
+	for (int i = 6; i < argc; i++)
+		if (string(argv[i]) == "--snapshot")
+			use_snapshot = true;
 	
 	automaton* aut = new automaton;
 	unsigned int state_num = 0;
 	
-	 if(query_type == 1) //Q1 a*
+	if(query_type == 0) // a query given as a regular expression over labels in argv[6], like "1 2* 3*" for Q9 with a=1, b=2, c=3. The DFA and the scores are derived from the expression.
+	{
+		regex_compiler rc;
+		if (argc < 7 || !rc.compile(argv[6], aut))
+		{
+			cout << "wrong regular expression " << (argc < 7 ? "" : rc.error_msg) << endl;
+			return 0;
+		}
+		state_num = rc.state_num;
+		scores = rc.scores;
+	}
+	else if(query_type == 1) //Q1 a*
     {
     	state_num = 1;
         aut->set_final_state(0);
@@ -142,321 +154,76 @@ int main(int argc, char* argv[])
     	cout<<"wrong query type"<<endl;
     	return 0;
 	}
+	aut->compile(); // build the transition table of the DFA, used in the innermost loops of the algorithms.
 	
 	unsigned int w = 3600*24*days;
-	streaming_graph* sg = new streaming_graph(w);
+	streaming_graph* sg = new streaming_graph(w, use_snapshot);
 	sg->window_slide = 3600*hour;
-	unsigned int s, d, l;
-	unsigned long long t;
+	string names[] = { "", "S-PATH", "LM-SRPQ", "LM-DF", "LM-NT", "LM-random", "Brutal Search" };
+	string file_names[] = { "", "S-PATH", "LM", "DF", "NT", "random", "brutal" }; // prefixes of the output files
+	if (algorithm < 1 || algorithm > 6) // checked before the pipeline starts its reader thread
+	{
+		cout << "wrong algorithm type" << endl;
+		return 0;
+	}
+	ingest_pipeline fin(data_path, aut, 3600*hour); // reads a text file or a binary edge log produced by edge_convert on another thread, and drops the edges with labels not in the query.
 	string prefix = "./"; // path of the out put files
 	string postfix = ".txt";
-	unsigned int slice = 0;
-	unsigned int t0 = 0;
-	vector<unsigned int> insertion_time;
-	unsigned int edge_number = 0;
-	
+	unsigned int checkpoint_slices = days*24/hour; // memory is output when the window slides by its length
+	run_report report;
+	report.algorithm = names[algorithm];
+	report.data_path = data_path;
+	report.window = w;
+	report.slide = 3600*hour;
+	ofstream fout1((prefix + file_names[algorithm] + "-memory" + postfix).c_str()); // memory of the algorithm, measured at each checkpoint, including other information like result pair number and tree node number.
+
 	if(algorithm==1){
 	RPQ_forest* f1 = new RPQ_forest(sg, aut);
-	ofstream fout1((prefix+ "S-PATH-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"S-PATH-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"S-PATH-speed"+postfix).c_str()); //time used by two algorithms
-	clock_t start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f1->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		
-		if(time/(3600*hour)>slice)
-		{
-			slice++;
-			f1->expire(time);
-			// cout << slice << " slices have been inserted" << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f1->count(fout1); // a checkpoint
-		}
-	}
-	clock_t finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "S-PATH time used " << time_used << endl;
-	cout<< "S-PATH speed "<<double(edge_number)/time_used<<endl;
-	fout3<< " S-PATH time used " << time_used << endl;
-	fout3<< "S-PATH speed "<<double(edge_number)/time_used<<endl;
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
+	run_benchmark(f1, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
 	delete f1;
 }
 
-if(algorithm==2){	
-	ofstream fout1((prefix+ "LM-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"LM-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"LM-speed"+postfix).c_str()); //time used by two algorithms
-	
+if(algorithm==2){
 	LM_forest* f2 = new LM_forest(sg, aut);
 	for(int i=0;i<state_num;i++)
 			f2->aut_scores[i] = scores[i];
-	clock_t	start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f2->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		if (time / (3600*hour) > slice) {
-			slice++;
-			f2->expire(time);
-			f2->dynamic_lm_select(candidate_rate, benefit_threshold);
-
-			// cout << slice << " slices have been inserted, time: " << time << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f2->count(fout1);
-		}
-	}
-	clock_t	finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "LM-SRPQ time used " << time_used << endl;
-	cout << "LM-SRPQ speed " << (double)edge_number / time_used << endl;
-	fout3<< "LM-SRPQ time used " << time_used << endl;
-	fout3 << "LM-SRPQ speed " << (double)edge_number / time_used << endl;
+	run_benchmark(f2, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
     cout << "resulting paths: " << f2->distinct_results << "\n\n";
-	
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-
 	f2->export_result(prefix+"LM-results.csv");
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
 	delete f2;
 }
 
-if(algorithm==3){	
-	ofstream fout1((prefix+ "DF-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"DF-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"DF-speed"+postfix).c_str()); //time used by two algorithms
-	
+if(algorithm==3){
 	LM_DF* f2 = new LM_DF(sg, aut);
 	for(int i=0;i<state_num;i++)
 			f2->aut_scores[i] = scores[i];
-	clock_t	start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f2->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		if (time / (3600*hour) > slice) {
-			slice++;
-			f2->expire(time);
-			f2->dynamic_lm_select(candidate_rate, benefit_threshold);
-
-			cout << slice << " slices have been inserted" << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f2->count(fout1);
-		}
-	}
-	clock_t	finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "LM-DF time used " << time_used << endl;
-	cout << "LM-DF speed " << (double)edge_number / time_used << endl;
-	fout3<< " LM-DF time used " << time_used << endl;
-	fout3 << "LM-DF speed " << (double)edge_number / time_used << endl;
-	
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
+	run_benchmark(f2, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
 	delete f2;
 }
 
-if(algorithm==4){	
-	ofstream fout1((prefix+ "NT-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"NT-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"NT-speed"+postfix).c_str()); //time used by two algorithms
-	
+if(algorithm==4){
 	LM_NT* f2 = new LM_NT(sg, aut);
 	for(int i=0;i<state_num;i++)
 			f2->aut_scores[i] = scores[i];
-	clock_t	start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f2->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		if (time / (3600*hour) > slice) {
-			slice++;
-			f2->expire(time);
-			f2->dynamic_lm_select(candidate_rate, benefit_threshold);
-
-			cout << slice << " slices have been inserted" << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f2->count(fout1);
-		}
-	}
-	clock_t	finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "LM-NT time used " << time_used << endl;
-	cout << "LM-NT speed " << (double)edge_number / time_used << endl;
-	fout3<< " LM-NT time used " << time_used << endl;
-	fout3 << "LM-NT speed " << (double)edge_number / time_used << endl;
-	
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
+	run_benchmark(f2, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
 	delete f2;
 }
 
-if(algorithm==5){	
-	ofstream fout1((prefix+ "random-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"random-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"random-speed"+postfix).c_str()); //time used by two algorithms
-	
+if(algorithm==5){
 	LM_random* f2 = new LM_random(sg, aut);
 	for(int i=0;i<state_num;i++)
 			f2->aut_scores[i] = scores[i];
-	clock_t	start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f2->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		if (time / (3600*hour) > slice) {
-			slice++;
-			f2->expire(time);
-			f2->dynamic_lm_select(candidate_rate, benefit_threshold);
-
-			cout << slice << " slices have been inserted" << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f2->count(fout1);
-		}
-	}
-	clock_t	finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "LM-random time used " << time_used << endl;
-	cout << "LM-random speed " << (double)edge_number / time_used << endl;
-	fout3<< " LM-random time used " << time_used << endl;
-	fout3 << "LM-random speed " << (double)edge_number / time_used << endl;
-	
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
+	run_benchmark(f2, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
 	delete f2;
 }
 
-
-if(algorithm==6){	
-	ofstream fout1((prefix+ "brutal-memory"+postfix).c_str()); // memory of S-PATH, memory mearsued at each checkpoint will be output, including 
-	ofstream fout2((prefix+"brutal-insertion-latency"+postfix).c_str());
-	ofstream fout3((prefix+"brutal-speed"+postfix).c_str()); //time used by two algorithms
-	
+if(algorithm==6){
 	Brutal_Solver* f2 = new Brutal_Solver(sg, aut);
-	clock_t	start = clock();
-	while (fin >> s >> d >> l >> t)
-	{
-		edge_number++;
-		if(t0==0)
-			t0 = t;
-		unsigned int time = t-t0+1;
-		auto insertion_start = std::chrono::steady_clock::now();
-		f2->insert_edge(s, d, l, time);
-		auto insertion_end = std::chrono::steady_clock::now();
-		auto duration = std::chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
-		insertion_time.push_back(duration.count());
-		if (time / (3600*hour) > slice) {
-			slice++;
-			f2->expire(time);
-
-			cout << slice << " slices have been inserted" << endl;
-			if (slice>0&&slice%(days*24/hour) == 0)
-				f2->count(fout1);
-		}
-	}
-	clock_t	finish = clock();
-	cout << "insert finished " << endl;
-	unsigned int time_used = (double)(finish - start) / CLOCKS_PER_SEC;
-	cout << "Brutal Search time used " << time_used << endl;
-	cout << "Brutal Search speed " << (double)edge_number / time_used << endl;
-	fout3<< " Brutal Search time used " << time_used << endl;
-	fout3 << "Brutal Search speed " << (double)edge_number / time_used << endl;
-	
-	sort(insertion_time.begin(), insertion_time.end(), compare);
-	if(insertion_time.size()>(edge_number/100))
-		insertion_time.erase(insertion_time.begin()+(edge_number/100), insertion_time.end());
-	for(int i=0;i<insertion_time.size();i++)
-		fout2<<insertion_time[i]<<endl;
-		
-	insertion_time.clear();
-	fout1.close();
-	fout2.close();
-	fout3.close();
+	run_benchmark(f2, fin, report, fout1, checkpoint_slices, candidate_rate, benefit_threshold);
 	delete f2;
 }
+	fout1.close();
+	cout << "insert finished " << endl;
+	write_report(report, prefix, file_names[algorithm]);
 	delete sg;
 }
-
@@ -0,0 +1,25 @@
+#include<iostream>
+#include<string>
+#include "./source/edge_stream.h"
+using namespace std;
+
+// converts a text edge file ("src_id dst_id label timestamp" per row) into a binary edge log, which the demo reads through mmap.
+// Run: ./edge_convert (path of the text file) (path of the binary edge log)
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cout << "usage: ./edge_convert (path of the text file) (path of the binary edge log)" << endl;
+		return 1;
+	}
+	unsigned long long n = 0;
+	string error_msg;
+	if (!edge_stream::convert(argv[1], argv[2], n, error_msg))
+	{
+		cout << "conversion failed: " << error_msg << endl;
+		return 1;
+	}
+	cout << n << " edges converted" << endl;
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include<vector>
+#include<string>
+#include<map>
+#include<stdlib.h>
+#include "./source/regex_compiler.h"
+using namespace std;
+
+// checks the DFA minimization of the regular expression compiler. Each expression is compiled twice, with and without minimization, and the two DFAs are run on all the label strings up to a given length,
+// which must be accepted or rejected by both. The expressions are the ones which failed before, followed by random expressions over labels 0-2.
+// Run: ./regex_check (number of random expressions, 20000 by default) (largest string length, 8 by default)
+// The expressions with different languages are output, and the return value is 1 if there is any.
+
+const char* known_cases[] = { "(1 0 (1)*)? (((2|2))+)+", "(((0)+|1 1) (1)+ 1)*", "(((1)* (0)*)?|(1 0)+)" }; // minimization used to change the language of these expressions
+
+string random_regex(unsigned int depth) // a random expression over labels 0-2, with nesting not deeper than depth
+{
+	unsigned int kind = depth ? rand() % 6 : 0;
+	string r;
+	if (kind == 0)
+		r = to_string(rand() % 3);
+	else if (kind == 1)
+		r = random_regex(depth - 1) + " " + random_regex(depth - 1);
+	else if (kind == 2)
+		r = "(" + random_regex(depth - 1) + "|" + random_regex(depth - 1) + ")";
+	else
+		r = "(" + random_regex(depth - 1) + ")" + "*+?"[kind - 3];
+	return r;
+}
+
+bool accepts(vector<map<int, int> >& dfa, vector<bool>& final, vector<int>& str) // run the DFA from state 0
+{
+	int s = 0;
+	for (unsigned int i = 0; i < str.size(); i++)
+	{
+		map<int, int>::iterator it = dfa[s].find(str[i]);
+		if (it == dfa[s].end())
+			return false;
+		s = it->second;
+	}
+	return final[s];
+}
+
+bool same_language(const string& regex, unsigned int max_len) // compare the DFA before and after minimization on all the strings over labels 0-2 not longer than max_len.
+{
+	regex_compiler rc;
+	rc.expr = regex;
+	rc.pos = 0;
+	pair<int, int> frag;
+	if (!rc.parse_alternation(frag))
+		return true;
+	rc.subset_construction(frag.first, frag.second);
+	vector<map<int, int> > dfa = rc.dfa;
+	vector<bool> dfa_final = rc.dfa_final;
+	rc.minimize();
+	vector<int> str;
+	while (true)
+	{
+		if (accepts(dfa, dfa_final, str) != accepts(rc.dfa, rc.dfa_final, str))
+		{
+			cout << "\"" << regex << "\" differs on \"";
+			for (unsigned int i = 0; i < str.size(); i++)
+				cout << (i ? " " : "") << str[i];
+			cout << "\"" << endl;
+			return false;
+		}
+		unsigned int i = 0; // next string, in the order of length and then labels
+		while (i < str.size() && str[i] == 2)
+			str[i++] = 0;
+		if (i < str.size())
+			str[i]++;
+		else if (str.size() < max_len)
+			str.push_back(0);
+		else
+			return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int regex_num = argc > 1 ? atoi(argv[1]) : 20000;
+	unsigned int max_len = argc > 2 ? atoi(argv[2]) : 8;
+	srand(1);
+	unsigned int wrong = 0;
+	for (unsigned int i = 0; i < sizeof(known_cases) / sizeof(known_cases[0]); i++)
+		wrong += !same_language(known_cases[i], max_len);
+	for (unsigned int i = 0; i < regex_num; i++)
+		wrong += !same_language(random_regex(4), max_len);
+	cout << regex_num + sizeof(known_cases) / sizeof(known_cases[0]) << " expressions checked, " << wrong << " with a different language after minimization" << endl;
+	return wrong ? 1 : 0;
+}
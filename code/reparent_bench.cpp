@@ -0,0 +1,42 @@
+#include<vector>
+#include<string>
+#include<stdlib.h>
+#include<chrono>
+#include "./source/forest_struct.h"
+using namespace std;
+
+// microbenchmark of re-parenting in a spanning tree. A root with a given fanout is built, and random children are moved between the root and another parent with substitute_parent,
+// which is what expand and insert_per_tree do when a newer path to an existing node is found. The cost per operation should not grow with the fanout.
+// Run: ./reparent_bench (number of re-parent operations per fanout, 1000000 by default)
+
+int main(int argc, char* argv[])
+{
+	unsigned int op_num = argc > 1 ? atoi(argv[1]) : 1000000;
+	unsigned int fanouts[] = { 16, 256, 4096, 65536, 1048576 };
+	srand(1);
+	tree_node_pool node_pool;
+	for (unsigned int f = 0; f < sizeof(fanouts) / sizeof(fanouts[0]); f++)
+	{
+		unsigned int fanout = fanouts[f];
+		RPQ_tree* tree_pt = new RPQ_tree(&node_pool);
+		tree_pt->root = tree_pt->add_node(0, 0, NULL, MAX_INT, MAX_INT);
+		tree_node* other = tree_pt->add_node(1, 0, tree_pt->root, MAX_INT, MAX_INT); // the other parent
+		vector<tree_node*> children;
+		for (unsigned int i = 0; i < fanout; i++)
+			children.push_back(tree_pt->add_node(i + 2, 1, tree_pt->root, 1, 1));
+		unsigned long long checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < op_num; i++)
+		{
+			tree_node* child = children[(unsigned int)rand() % fanout];
+			tree_node* parent = child->parent == tree_pt->root ? other : tree_pt->root;
+			tree_pt->substitute_parent(parent, child);
+			checksum += parent->node_ID;
+		}
+		auto finish = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration_cast<chrono::nanoseconds>(finish - start).count();
+		cout << "fanout " << fanout << ": " << ns / op_num << " ns per re-parent (checksum " << checksum << ")" << endl;
+		delete tree_pt;
+	}
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include<vector>
+#include<string>
+#include<map>
+#include<stdlib.h>
+#include "./source/S-PATH.h"
+#include "./source/LM-SRPQ.h"
+#include "./source/regex_compiler.h"
+#include "./source/edge_stream.h"
+using namespace std;
+
+// checks the results of LM-SRPQ against S-PATH on the same stream. Both algorithms consume the stream with their own streaming graph, the window slides like in the demo, and after each slide
+// the pairs whose timestamp is inside the window of the graph (not older than current time - window size + window slide) are compared, including their timestamps.
+// Both algorithms expire their results one slide later than the graph. The pairs in that last slide may have lost their paths with the expired edges, thus they are not compared.
+// Run: ./result_check (path of data) (window size, with seconds as unit) (window slide, with seconds as unit) (regular expression of the query, like "1 2* 3*")
+// Mismatched pairs are output with the external vertex IDs, and the return value is 1 if any pair mismatches.
+
+map<unsigned long long, unsigned int> window_results(result_set& results, streaming_graph* g, unsigned int threshold) // results with timestamp not smaller than the threshold, keyed by the external IDs.
+{
+	map<unsigned long long, unsigned int> r;
+	for (result_set::iterator iter = results.begin(); iter != results.end(); iter++)
+		if (iter->second >= threshold)
+			r[merge_long_long((unsigned long long)g->external_id(iter->first >> 32), g->external_id(iter->first & 0xFFFFFFFF))] = iter->second;
+	return r;
+}
+
+unsigned int compare(map<unsigned long long, unsigned int>& a, map<unsigned long long, unsigned int>& b, const char* name_a, const char* name_b, unsigned int slice, bool check_time)
+	// output the pairs of a missing in b, and if check_time is true, also the pairs with another timestamp in b.
+{
+	unsigned int mismatch = 0;
+	for (map<unsigned long long, unsigned int>::iterator iter = a.begin(); iter != a.end(); iter++)
+	{
+		map<unsigned long long, unsigned int>::iterator other = b.find(iter->first);
+		if (other != b.end() && (!check_time || other->second == iter->second))
+			continue;
+		mismatch++;
+		cout << "slice " << slice << ": pair " << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << name_a << " " << iter->second << " " << name_b << " ";
+		if (other == b.end())
+			cout << "missing" << endl;
+		else
+			cout << other->second << endl;
+	}
+	return mismatch;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 5)
+	{
+		cout << "usage: ./result_check (path of data) (window size in seconds) (window slide in seconds) (regular expression)" << endl;
+		return 1;
+	}
+	unsigned int window_size = atoi(argv[2]);
+	unsigned int window_slide = atoi(argv[3]);
+	automaton* aut = new automaton;
+	regex_compiler rc;
+	if (!rc.compile(argv[4], aut))
+	{
+		cout << "wrong regular expression " << rc.error_msg << endl;
+		return 1;
+	}
+	aut->compile();
+	edge_stream fin(argv[1]);
+	if (!fin.is_open())
+	{
+		cout << "cannot open " << argv[1] << endl;
+		return 1;
+	}
+
+	streaming_graph* g1 = new streaming_graph(window_size);
+	g1->window_slide = window_slide;
+	streaming_graph* g2 = new streaming_graph(window_size);
+	g2->window_slide = window_slide;
+	RPQ_forest* f1 = new RPQ_forest(g1, aut);
+	LM_forest* f2 = new LM_forest(g2, aut);
+	for (unsigned int i = 0; i < rc.state_num; i++)
+		f2->aut_scores[i] = rc.scores[i];
+
+	unsigned int s, d, l;
+	unsigned long long t;
+	unsigned long long t0 = 0;
+	unsigned int slice = 0;
+	unsigned int checked = 0, mismatch = 0;
+	while (fin.next(s, d, l, t))
+	{
+		if (t0 == 0)
+			t0 = t;
+		unsigned int time = t - t0 + 1;
+		f1->insert_edge(s, d, l, time);
+		f2->insert_edge(s, d, l, time);
+		if (window_slide && time / window_slide > slice)
+		{
+			slice++;
+			f1->expire(time);
+			f2->expire(time);
+			f2->dynamic_lm_select(0.2, 1.5);
+			unsigned int threshold = time + window_slide > window_size ? time + window_slide - window_size : 0; // tail of the window of the graph
+			map<unsigned long long, unsigned int> r1 = window_results(f1->result_pairs, g1, threshold);
+			map<unsigned long long, unsigned int> r2 = window_results(f2->result_pairs, g2, threshold);
+			mismatch += compare(r1, r2, "S-PATH", "LM-SRPQ", slice, true);
+			mismatch += compare(r2, r1, "LM-SRPQ", "S-PATH", slice, false);
+			checked++;
+		}
+	}
+	cout << checked << " slides checked, " << mismatch << " mismatched pairs" << endl;
+	delete f1;
+	delete f2;
+	delete g1;
+	delete g2;
+	delete aut;
+	return mismatch ? 1 : 0;
+}
@@ -24,11 +24,12 @@ public:
 	streaming_graph* g; // pointer to the streaming graph .
 	automaton* aut; // pointer to the DFA of the regular expression. 
 	product_graph* pg;
-	unordered_map<unsigned long long, unsigned int> result_pairs; // result set, maps from vertex paris to the largest timestamp of regular paths between them
+	result_set result_pairs; // result set, maps from vertex paris to the largest timestamp of regular paths between them
 
 	Brutal_Solver(streaming_graph* g_, automaton* automaton)
 	{
 		g = g_;
+		result_pairs.g = g_;
 		aut = automaton;
 		pg = new product_graph;
 	}
@@ -45,10 +46,7 @@ public:
 		{
 			unsigned long long result_pair = it->first;
 			unsigned int time = it->second;
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time); // if the vertex pair exists, update its timestamp
-			else
-				result_pairs[result_pair] = time; // else add the vertex pair.
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -67,17 +65,16 @@ public:
 			unsigned int time = p.second;
 			if (aut->check_final_state((info & 0xFFFFFFFF)))
 				final_state_nodes[(info >> 32)] = max(time, final_state_nodes[(info >> 32)]);
-			vector<pair<unsigned long long, unsigned int>> vec;
-			pg->get_successor((info >> 32), (info & 0xFFFFFFFF), vec);
-			for (int i = 0; i < vec.size(); i++)
+			for (pg_edge* e = pg->successor_list((info >> 32), (info & 0xFFFFFFFF)); e; e = e->src_next) // scan the successors in place
 			{
-				unsigned int suc_time = min(time, vec[i].second);
-				if (time_index.find(vec[i].first) != time_index.end() && time_index[vec[i].first] >= suc_time)
+				unsigned long long suc_info = merge_long_long(e->dst, e->dst_state);
+				unsigned int suc_time = min(time, e->timestamp);
+				if (time_index.find(suc_info) != time_index.end() && time_index[suc_info] >= suc_time)
 					continue;
 				else
 				{
-					time_index[vec[i].first] = suc_time;
-					q.push(make_pair(vec[i].first, suc_time));
+					time_index[suc_info] = suc_time;
+					q.push(make_pair(suc_info, suc_time));
 				}
 			}
 		}
@@ -98,17 +95,16 @@ public:
 			unsigned int time = time_index[info];
 			if ((info & 0xFFFFFFFF)==0)
 				initial_state_nodes[(info >> 32)] = max(time, initial_state_nodes[(info >> 32)]);
-			vector<pair<unsigned long long, unsigned int>> vec;
-			pg->get_precursor((info >> 32), (info & 0xFFFFFFFF), vec);
-			for (int i = 0; i < vec.size(); i++)
+			for (pg_edge* e = pg->precursor_list((info >> 32), (info & 0xFFFFFFFF)); e; e = e->dst_next) // scan the precursors in place
 			{
-				unsigned int pre_time = min(time, vec[i].second);
-				if (time_index.find(vec[i].first) != time_index.end() && time_index[vec[i].first] >= pre_time)
+				unsigned long long pre_info = merge_long_long(e->src, e->src_state);
+				unsigned int pre_time = min(time, e->timestamp);
+				if (time_index.find(pre_info) != time_index.end() && time_index[pre_info] >= pre_time)
 					continue;
 				else
 				{
-					time_index[vec[i].first] = pre_time;
-					q.push(make_pair(vec[i].first, pre_time));
+					time_index[pre_info] = pre_time;
+					q.push(make_pair(pre_info, pre_time));
 				}
 			}
 		}
@@ -117,10 +113,11 @@ public:
 
 	void insert_edge(unsigned int s, unsigned int d, unsigned int label, unsigned int timestamp)
 	{
-		vector<pair<int, int>> vec;
-		aut->get_possible_state(label, vec);
+		const vector<pair<int, int> >& vec = aut->get_state_pairs(label);
 		if(vec.empty())
 			return;
+		s = g->vertex_id(s); // the product graph works on internal vertex IDs of the streaming graph.
+		d = g->vertex_id(d);
 		g->insert_edge(s, d, label, timestamp);
 		unordered_map<unsigned long long, unsigned int> updated_paths;
 		for (int i = 0; i < vec.size(); i++)
@@ -152,17 +149,7 @@ public:
 	}
 	void results_update(int time) // given the threshold of expiration, delete all the expired result pairs.
 	{
-		if (time <= 0)
-			return;
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end();)
-		{
-			if (iter->second < time) {
-				iter = result_pairs.erase(iter);
-			}
-			else
-				iter++;
-		}
-		shrink(result_pairs);
+		result_pairs.expire(time); // only the calendar buckets older than the threshold are visited.
 	}
 
 
@@ -177,8 +164,7 @@ public:
 			unsigned int src = deleted_edges[i].s;
 			unsigned int dst = deleted_edges[i].d;
 			unsigned int label = deleted_edges[i].label; // for each expired edge, find its dst node. All the expired nodes in the spanning forest must be in a subtree of such dst node.
-			vector<pair<int, int>> vec;
-			aut->get_possible_state(label, vec); // get possible states of the dst node.
+			const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // get possible states of the dst node.
 			for (int j = 0; j < vec.size(); j++) {
 				int dst_state = vec[j].second;
 				int src_state = vec[j].first;
@@ -192,15 +178,15 @@ public:
 
 	void output_match(ofstream& fout) // output the recorded result pairs, used to 
 	{
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
-			fout << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << iter->second << endl;
+		for (result_set::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
+			fout << g->external_id(iter->first >> 32) << " " << g->external_id(iter->first & 0xFFFFFFFF) << " " << iter->second << endl; // translate the internal vertex IDs back to the IDs in the stream.
 	}
 	void count(ofstream& fout) // count the memory used in the algorithm, but exclude the memory of automaton and streaming graph, because they are essential for any algorithm.
 	{
 		unsigned int um_size = sizeof(unordered_map<unsigned int, unsigned int>); // size of statistics in a map, which does not change with the key-value type, usually is 56, but may change with the system.
 		unsigned int m_size = sizeof(map<unsigned int, unsigned int>); // size of pointers and statistics in a map, which does not change with the key-value type, usually is 48, but may change with the system.
-		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(result_pairs.size() * 24 + result_pairs.bucket_count() * 8 + um_size) / (1024 * 1024)) << endl;  // number of result vertex pairs, and the memory used to store these results.
-		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(result_pairs.size() * 24 + result_pairs.bucket_count() * 8 + um_size) / (1024 * 1024)) << endl;
+		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;  // number of result vertex pairs, and the memory used to store these results.
+		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;
 		
 		unsigned int pg_size = 0;
 		pg_size += um_size;
@@ -24,12 +24,13 @@ public:
 	streaming_graph* g; // pointer to the streaming graph
 	automaton* aut;// pointer to the DFA generated by the regular expression
 	map<unsigned int, double> aut_scores; // this map stores the depth we estimated for each state in the DFA
+	tree_node_pool node_pool; // memory of the tree nodes of this forest, shared by all its trees.
 	unordered_map<unsigned long long, RPQ_tree*> forests; // unordered map that maps each vertex ID-state pair to the spanning tree rooted at it. the vertex ID and the state is merged into an Unsigned long long 
 	unordered_map<unsigned long long, RPQ_tree*> DF_forest; // forests of depdency graph trees (DF trees), here we still use the structure of RPQ_tree*, but in fact the DF tree is simpler thant RPQ tree, with no structes landmark set. We use RPQ_tree* just for convenience 
 	map<unsigned int, tree_info_index*> v2t_index; // Maps each state to a tree_info_index, reverse index that maps a graph vertex to the normal trees that contains it.
 	map<unsigned int, tree_info_index*> v2d_index;// which is a reverse index that maps a landmark to the dependency graph tree that contains it. Not that we only build dependency graph trees for initial state node.
 	map<unsigned int, lm_info_index*> v2l_index; // Maps each state to a lm_info_index, reverse index that maps a graph vertex to the LM trees that contains it.
-	unordered_map<unsigned long long, unsigned int> result_pairs;
+	result_set result_pairs;
 	unordered_map<unsigned long long, unsigned int> result_lm;
 	unordered_set<unsigned long long> landmarks; // set of landmarks, vertex ID and states are merged.
 	bool record_path;
@@ -37,6 +38,7 @@ public:
 	LM_DF(streaming_graph* g_, automaton* automaton)
 	{
 		g = g_;
+		result_pairs.g = g_;
 		aut = automaton;
 		record_path = true;
 	}
@@ -73,10 +75,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -89,10 +88,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -219,14 +215,14 @@ public:
 				unsigned int dst_state = (iter2->first & 0xFFFFFFFF);
 				unsigned int time = min(iter2->second, tmp->timestamp);
 
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(dst_id) == tree_pt->node_map[dst_state]->index.end())
+				if (tree_pt->find_node(dst_id, dst_state) == NULL)
 				{
 					tree_node* new_node = add_df_node(tree_pt, dst_id, dst_state, root_ID, tmp, min(tmp->timestamp, iter2->second), iter2->second);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[dst_id];
+					tree_node* dst_pt = tree_pt->find_node(dst_id, dst_state);
 					if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
 					{
 						if (dst_pt->parent != tmp)
@@ -268,14 +264,14 @@ public:
 					unsigned int dst_state = (iter2->first & 0xFFFFFFFF);
 					unsigned int time = min(iter2->second, tmp->timestamp);
 
-					if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(dst_id) == tree_pt->node_map[dst_state]->index.end())
+					if (tree_pt->find_node(dst_id, dst_state) == NULL)
 					{
 						tree_node* new_node = add_df_node(tree_pt, dst_id, dst_state, root_ID, tmp, min(tmp->timestamp, iter2->second), iter2->second);
 						q.push(new_node);
 					}
 					else
 					{
-						tree_node* dst_pt = tree_pt->node_map[dst_state]->index[dst_id];
+						tree_node* dst_pt = tree_pt->find_node(dst_id, dst_state);
 						if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
 						{
 							if (dst_pt->parent != tmp)
@@ -322,35 +318,33 @@ public:
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs); // get out edges of the src node
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // get out edges of the src node
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
 
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // if this node does not exist yet.
+				if (tree_pt->find_node(successor, dst_state) == NULL) // if this node does not exist yet.
 				{
 					tree_node* new_node;
 					if (if_lm_tree)
-						new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, sucs[i].timestamp);
+						new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, suc->timestamp);
 					else
-						new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, sucs[i].timestamp);
+						new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
 					{
 						if (dst_pt->parent != tmp)
 							tree_pt->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						q.push(dst_pt);
 					}
 				}
@@ -367,17 +361,16 @@ public:
 		unsigned int root_ID = lm_tree->root->node_ID;
 		unsigned int root_state = lm_tree->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(lm_tree->node_map.find(src_state) != lm_tree->node_map.end());
-		assert(lm_tree->node_map[src_state]->index.find(s) != lm_tree->node_map[src_state]->index.end());
-		tree_node* src_pt = lm_tree->node_map[src_state]->index[s];
+		assert(lm_tree->find_node(s, src_state) != NULL);
+		tree_node* src_pt = lm_tree->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 
 		tree_node* dst_pt = NULL;
-		if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.find(d) == lm_tree->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (lm_tree->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_lm_node(lm_tree, d, dst_state, lm_tree->root->node_ID, lm_tree->root->state, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { 
-			dst_pt = lm_tree->node_map[dst_state]->index[d];
+			dst_pt = lm_tree->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -401,18 +394,17 @@ public:
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(tree_pt->node_map.find(src_state) != tree_pt->node_map.end());
-		assert(tree_pt->node_map[src_state]->index.find(s) != tree_pt->node_map[src_state]->index.end());
-		tree_node* src_pt = tree_pt->node_map[src_state]->index[s];
+		assert(tree_pt->find_node(s, src_state) != NULL);
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 		unordered_map<unsigned int, unsigned int> updated_nodes;
 
 		tree_node* dst_pt = NULL;
-		if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (tree_pt->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { 
-			dst_pt = tree_pt->node_map[dst_state]->index[d];
+			dst_pt = tree_pt->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -434,17 +426,16 @@ public:
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(tree_pt->node_map.find(src_state) != tree_pt->node_map.end());
-		assert(tree_pt->node_map[src_state]->index.find(s) != tree_pt->node_map[src_state]->index.end());
-		tree_node* src_pt = tree_pt->node_map[src_state]->index[s];
+		assert(tree_pt->find_node(s, src_state) != NULL);
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 
 		tree_node* dst_pt = NULL;
-		if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (tree_pt->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_df_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { 
-			dst_pt = tree_pt->node_map[dst_state]->index[d];
+			dst_pt = tree_pt->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -464,9 +455,8 @@ public:
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(tree_pt->node_map.find(src_state) != tree_pt->node_map.end());
-		assert(tree_pt->node_map[src_state]->index.find(s) != tree_pt->node_map[src_state]->index.end());
-		tree_node* src_pt = tree_pt->node_map[src_state]->index[s];
+		assert(tree_pt->find_node(s, src_state) != NULL);
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 
 		vector<tree_node*> node2expand;
@@ -475,10 +465,10 @@ public:
 			unsigned int d = (iter->first >> 32);
 			unsigned int dst_state = (iter->first & 0xFFFFFFFF);
 			unsigned int timestamp = iter->second;
-			if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+			if (tree_pt->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 				dst_pt = add_df_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 			else { 
-				dst_pt = tree_pt->node_map[dst_state]->index[d];
+				dst_pt = tree_pt->find_node(d, dst_state);
 				if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 				{
 					if (dst_pt->parent != src_pt)
@@ -500,17 +490,14 @@ public:
 		if (forests.find(info) != forests.end())
 		{
 			RPQ_tree* tree_pt = forests[info];
-			for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+			for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 			{
-				if (aut->check_final_state(iter->first))
-				{
-					for (unordered_map<unsigned int, tree_node*>::iterator node_iter = iter->second->index.begin(); node_iter != iter->second->index.end(); node_iter++)
-					{
-						unsigned int time = node_iter->second->timestamp;
-						if (final_nodes.find(node_iter->first) == final_nodes.end() || final_nodes[node_iter->first] < time)
-							final_nodes[node_iter->first] = time;
-					}
-				}
+				tree_node* node = tree_pt->node_map.table[i];
+				if (!node || !aut->check_final_state(node->state))
+					continue;
+				unsigned int time = node->timestamp;
+				if (final_nodes.find(node->node_ID) == final_nodes.end() || final_nodes[node->node_ID] < time)
+					final_nodes[node->node_ID] = time;
 			}
 		}
 	}
@@ -532,11 +519,12 @@ public:
 					unsigned int id = tmp->node_ID;
 					unsigned long long rp = merge_long_long(root, id);
 					unsigned int time = min(lm_time, tmp->timestamp);
-					if (result_pairs.find(rp) != result_pairs.end() && result_pairs[rp] >= time)
+					result_entry* rp_entry = result_pairs.find(rp);
+					if (rp_entry && rp_entry->second >= time)
 						continue;
 					else
 					{
-						result_pairs[rp] = time;
+						result_pairs.update(rp, time);
 						tree_node* child = tmp->child;
 						while (child)
 						{
@@ -566,18 +554,19 @@ public:
 
 		if (aut->acceptable_labels.find(label) == aut->acceptable_labels.end()) // we only insert the edge if the automaton can accept it, in this case the streaming graph is a layer graph containing necessray edges. 
 			return;
+		s = g->vertex_id(s); // the forests work on internal vertex IDs of the streaming graph.
+		d = g->vertex_id(d);
 		g->insert_edge(s, d, label, timestamp);
 		if (aut->get_suc(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end()) // we need to build a new tree
 		{
-			RPQ_tree* new_tree = new RPQ_tree();
+			RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 			if (landmarks.find(merge_long_long(s, 0)) == landmarks.end()) // a normal tree
 				new_tree->root = add_node(new_tree, s, 0, s, NULL, MAX_INT, MAX_INT);
 			else // an LM tree
 				new_tree->root = add_lm_node(new_tree, s, 0, s, 0, NULL, MAX_INT, MAX_INT);
 			forests[merge_long_long(s, 0)] = new_tree;
 		}
-		vector<pair<int, int> >vec;
-		aut->get_possible_state(label, vec); // find all the state paris that can accept this label
+		const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // find all the state paris that can accept this label
 		for (unsigned int i = 0; i < vec.size(); i++) {
 			unsigned int src_state = vec[i].first;
 			unsigned int dst_state = vec[i].second;
@@ -591,7 +580,7 @@ public:
 					continue;
 				if (src_state == 0 && !updated_de.empty() && DF_forest.find(merge_long_long(s, src_state)) == DF_forest.end())
 				{
-					RPQ_tree* new_tree = new RPQ_tree();
+					RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 					new_tree->root = add_df_node(new_tree, s, 0, s, NULL, MAX_INT, MAX_INT);
 					DF_forest[merge_long_long(s, 0)] = new_tree;
 				}
@@ -605,22 +594,18 @@ public:
 						{
 							RPQ_tree* DF_tree = tmp->tree;
 							unordered_map<unsigned long long, unsigned int> updated_lm;
-							if (DF_tree->node_map.find(src_state) != DF_tree->node_map.end())
+							tree_node* src_DF_node = DF_tree->find_node(s, src_state);
+							if (src_DF_node)
 							{
-								if (DF_tree->node_map[src_state]->index.find(s) != DF_tree->node_map[src_state]->index.end())
+								unsigned int src_DF_time = src_DF_node->timestamp;
+								if(DF_tree->root->node_ID!=s|| DF_tree->root->state!=src_state)
+									update_result(updated_nodes, DF_tree->root->node_ID, src_DF_time);
+								batch_insert_edge_df_tree(s, src_state, updated_de, DF_tree, updated_lm);
+								for (unordered_map<unsigned long long, unsigned int>::iterator DF_suc_iter = updated_lm.begin(); DF_suc_iter != updated_lm.end(); DF_suc_iter++)
 								{
-									tree_node* src_DF_node = DF_tree->node_map[src_state]->index[s];
-									unsigned int src_DF_time = src_DF_node->timestamp;
-									if(DF_tree->root->node_ID!=s|| DF_tree->root->state!=src_state)
-										update_result(updated_nodes, DF_tree->root->node_ID, src_DF_time);
-									batch_insert_edge_df_tree(s, src_state, updated_de, DF_tree, updated_lm);
-									for (unordered_map<unsigned long long, unsigned int>::iterator DF_suc_iter = updated_lm.begin(); DF_suc_iter != updated_lm.end(); DF_suc_iter++)
-									{
-										unordered_map<unsigned int, unsigned int> final_nodes;
-										get_final_nodes(DF_suc_iter->first, final_nodes);
-										update_result(final_nodes, DF_tree->root->node_ID, DF_suc_iter->second);
-									}
-
+									unordered_map<unsigned int, unsigned int> final_nodes;
+									get_final_nodes(DF_suc_iter->first, final_nodes);
+									update_result(final_nodes, DF_tree->root->node_ID, DF_suc_iter->second);
 								}
 							}
 							tmp = tmp->next;
@@ -651,7 +636,7 @@ public:
 							}
 							if ( lm_state== 0 && !updated_de.empty() && DF_forest.find(merge_long_long(lm_root, lm_state)) == DF_forest.end())
 							{
-								RPQ_tree* new_tree = new RPQ_tree();
+								RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 								new_tree->root = add_df_node(new_tree, lm_root, 0, lm_root, NULL, MAX_INT, MAX_INT);
 								DF_forest[merge_long_long(lm_root, lm_state)] = new_tree;
 							}
@@ -664,16 +649,13 @@ public:
 									while (DF_tmp)
 									{
 										RPQ_tree* DF_tree = DF_tmp->tree;
-										if (DF_tree->node_map.find(lm_state) != DF_tree->node_map.end())
+										tree_node* lm_DF_node = DF_tree->find_node(lm_root, lm_state);
+										if (lm_DF_node)
 										{
-											if (DF_tree->node_map[lm_state]->index.find(lm_root) != DF_tree->node_map[lm_state]->index.end())
-											{
-												tree_node* lm_DF_node = DF_tree->node_map[lm_state]->index[lm_root];
-												unsigned int lm_DF_time = lm_DF_node->timestamp;
-												if (DF_tree->root->node_ID != lm_root || DF_tree->root->state != lm_state)
-													update_result(updated_nodes, DF_tree->root->node_ID, lm_DF_time);
-												batch_insert_edge_df_tree(lm_root, lm_state, updated_de, DF_tree, dependency_paths[DF_tree->root->node_ID]);
-											}
+											unsigned int lm_DF_time = lm_DF_node->timestamp;
+											if (DF_tree->root->node_ID != lm_root || DF_tree->root->state != lm_state)
+												update_result(updated_nodes, DF_tree->root->node_ID, lm_DF_time);
+											batch_insert_edge_df_tree(lm_root, lm_state, updated_de, DF_tree, dependency_paths[DF_tree->root->node_ID]);
 										}
 										DF_tmp = DF_tmp->next;
 									}
@@ -703,7 +685,7 @@ public:
 							RPQ_tree* DF_tree;
 							if (DF_forest.find(merge_long_long(root_ID, 0)) == DF_forest.end())
 							{
-								DF_tree = new RPQ_tree();
+								DF_tree = new RPQ_tree(&node_pool);
 								DF_tree->root = add_df_node(DF_tree, root_ID, 0, root_ID, NULL, MAX_INT, MAX_INT);
 								DF_forest[merge_long_long(root_ID, 0)] = DF_tree;
 							}
@@ -753,35 +735,33 @@ public:
 
                         map<int, int> aut_edge;
                         aut->get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-                        vector<edge_info>sucs;
-                        g->get_timed_all_suc(tmp->node_ID, sucs); // get out edges of the src node
-                        for (int i = 0; i < sucs.size(); i++)
+                        for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // get out edges of the src node
                         {
-                                unsigned int successor = sucs[i].d;
-                                unsigned int label = sucs[i].label;
-                                unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+                                unsigned int successor = suc->d;
+                                unsigned int label = suc->label;
+                                unsigned int time = min(tmp->timestamp, suc->timestamp);
                                 if (aut_edge.find(label) == aut_edge.end())
                                         continue;
                                 int dst_state = aut_edge[label];
 
-                                if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // if this node does not exist yet.
+                                if (tree_pt->find_node(successor, dst_state) == NULL) // if this node does not exist yet.
                                 {
                                         tree_node* new_node;
                                         if (lm_expand_tree)
-                                                new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, sucs[i].timestamp);
+                                                new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, suc->timestamp);
                                         else
-                                                new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, sucs[i].timestamp);
+                                                new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp);
                                         q.push(new_node);
                                 }
                                 else
                                 {
-                                        tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+                                        tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
                                         if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
                                         {
                                                 if (dst_pt->parent != tmp)
                                                         tree_pt->substitute_parent(tmp, dst_pt);
                                                 dst_pt->timestamp = time;
-                                                dst_pt->edge_timestamp = sucs[i].timestamp;
+                                                dst_pt->edge_timestamp = suc->timestamp;
                                                 q.push(dst_pt);
                                         }
                                 }
@@ -795,13 +775,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_index(iter2->first, iter2->second->state, root_ID);
-				add_lm_index(tree_pt, iter2->first, iter2->second->state, root_ID, root_state);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_index(node->node_ID, node->state, root_ID);
+			add_lm_index(tree_pt, node->node_ID, node->state, root_ID, root_state);
 		}
 	}
 
@@ -809,13 +789,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_lm_index(iter2->first, iter2->second->state, root_ID, root_state);
-				add_index(tree_pt, iter2->first, iter2->second->state, root_ID);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_lm_index(node->node_ID, node->state, root_ID, root_state);
+			add_index(tree_pt, node->node_ID, node->state, root_ID);
 		}
 	}
 	void recover_subtree(unsigned int v, unsigned int state, RPQ_tree* lm_tree) // this function recovers the subtrees of a deleted landmark (v, state) in normal trees, lm_tree is the LM tree of this landmark.
@@ -890,30 +870,25 @@ public:
 					RPQ_tree* DF_tree = tree_to_delete[i];
 					if (DF_tree->root->node_ID == v && DF_tree->root->state == state)
 						continue;
-					if (DF_tree->node_map.find(state) != DF_tree->node_map.end())
+					tree_node* lm_DF_node = DF_tree->find_node(v, state);
+					if (lm_DF_node)
 					{
-						if (DF_tree->node_map[state]->index.find(v) != DF_tree->node_map[state]->index.end())
+						tree_node* parent = lm_DF_node->parent;
+						tree_node* child = lm_DF_node->child;
+						while (child)
 						{
-							tree_node* lm_DF_node = DF_tree->node_map[state]->index[v];
-							tree_node* parent = lm_DF_node->parent;
-							tree_node* child = lm_DF_node->child;
-							while (child)
-							{
-								tree_node* next = child->brother;
-								child->parent = parent;
-								child->brother = parent->child;
-								parent->child = child;
-								child->edge_timestamp = min(lm_DF_node->edge_timestamp, child->edge_timestamp);
-								child = next;
-							}
-							DF_tree->delete_node(lm_DF_node);
-							delete_df_index(v, state, DF_tree->root->node_ID);
-							if (DF_tree->root->child == NULL)
-							{
-								delete_df_index(DF_tree->root->node_ID, DF_tree->root->state, DF_tree->root->node_ID);
-								DF_forest.erase(merge_long_long(DF_tree->root->node_ID, DF_tree->root->state));
-								delete DF_tree;
-							}
+							tree_node* next = child->brother;
+							DF_tree->link_child(parent, child);
+							child->edge_timestamp = min(lm_DF_node->edge_timestamp, child->edge_timestamp);
+							child = next;
+						}
+						DF_tree->delete_node(lm_DF_node);
+						delete_df_index(v, state, DF_tree->root->node_ID);
+						if (DF_tree->root->child == NULL)
+						{
+							delete_df_index(DF_tree->root->node_ID, DF_tree->root->state, DF_tree->root->node_ID);
+							DF_forest.erase(merge_long_long(DF_tree->root->node_ID, DF_tree->root->state));
+							delete DF_tree;
 						}
 					}
 				}
@@ -939,6 +914,8 @@ public:
 					tree_pt->timed_landmarks[merge_long_long(v, state)] = lm_node->timestamp; // add the new landmark to the landmark set of the normal tree
 					tree_node* child = lm_node->child;  // carry out a BFS starting from childs of this landmark, and delete all the succesors in its subtree.
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
+					unsigned int node_num = 0;
 					queue<tree_node*> q;
 					while (child)
 					{
@@ -956,20 +933,15 @@ public:
 							q.push(child);
 							child = child->brother;
 						}
-						assert(tree_pt->node_map.find(cur->state) != tree_pt->node_map.end());
-						tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-						shrink(tree_pt->node_map[cur->state]->index);
-						if (tree_pt->node_map[cur->state]->index.empty()) {
-							delete tree_pt->node_map[cur->state];
-							tree_pt->node_map.erase(cur->state);
-						}
+						tree_pt->node_map.erase(cur->node_ID, cur->state);
 						if (cur->lm) {
 							tree_pt->timed_landmarks.erase(merge_long_long(cur->node_ID, cur->state));
 							shrink(tree_pt->timed_landmarks);
 						}
-						delete cur;
+						node_num++;
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, node_num);
 					tmp = tmp->next;
 				}
 			}
@@ -997,6 +969,8 @@ public:
 					tree_pt->timed_landmarks[merge_long_long(v, state)] = lm_node->timestamp;
 					tree_node* child = lm_node->child;
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
+					unsigned int node_num = 0;
 					queue<tree_node*> q;
 					while (child)
 					{
@@ -1015,19 +989,15 @@ public:
 							child = child->brother;
 						}
 
-						tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-						shrink(tree_pt->node_map[cur->state]->index);
-						if (tree_pt->node_map[cur->state]->index.empty()) {
-							delete tree_pt->node_map[cur->state];
-							tree_pt->node_map.erase(cur->state);
-						}
+						tree_pt->node_map.erase(cur->node_ID, cur->state);
 						if (cur->lm) {
 							tree_pt->timed_landmarks.erase(merge_long_long(cur->node_ID, cur->state));
 							shrink(tree_pt->timed_landmarks);
 						}
-						delete cur;
+						node_num++;
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, node_num);
 					tmp = tmp->next;
 				}
 			}
@@ -1047,32 +1017,30 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+					tree_node* node_pt = tree_pt->find_node(v, state);
+					if (node_pt)
 					{
-						if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end())
+						unsigned int df_edge_time = node_pt->timestamp;
+						if (DF_forest.find(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)) == DF_forest.end())
 						{
-							unsigned int df_edge_time = tree_pt->node_map[state]->index[v]->timestamp;
-							if (DF_forest.find(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)) == DF_forest.end())
-							{
-								RPQ_tree* DF_tree = new RPQ_tree;
-								tree_node* root = add_df_node(DF_tree, tree_pt->root->node_ID, tree_pt->root->state, tree_pt->root->node_ID, NULL, MAX_INT, MAX_INT);
-								DF_tree->root = root;
-								add_df_node(DF_tree, v, state, tree_pt->root->node_ID, root, df_edge_time, df_edge_time);
-								DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)] = DF_tree;
-							}
-							else
+							RPQ_tree* DF_tree = new RPQ_tree(&node_pool);
+							tree_node* root = add_df_node(DF_tree, tree_pt->root->node_ID, tree_pt->root->state, tree_pt->root->node_ID, NULL, MAX_INT, MAX_INT);
+							DF_tree->root = root;
+							add_df_node(DF_tree, v, state, tree_pt->root->node_ID, root, df_edge_time, df_edge_time);
+							DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)] = DF_tree;
+						}
+						else
+						{
+							RPQ_tree* DF_tree = DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)];
+							tree_node* lm_node = add_df_node(DF_tree, v, state, tree_pt->root->node_ID, DF_tree->root, df_edge_time, df_edge_time);
+							for (unordered_map<unsigned long long, unsigned int>::iterator iter = successors.begin(); iter != successors.end(); iter++)
 							{
-								RPQ_tree* DF_tree = DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)];
-								tree_node* lm_node = add_df_node(DF_tree, v, state, tree_pt->root->node_ID, DF_tree->root, df_edge_time, df_edge_time);
-								for (unordered_map<unsigned long long, unsigned int>::iterator iter = successors.begin(); iter != successors.end(); iter++)
+								tree_node* child = DF_tree->find_node((iter->first>>32), (iter->first&0xFFFFFFFF));
+								if (child != NULL&&child->timestamp<=min(lm_node->timestamp, iter->second))
 								{
-									tree_node* child = DF_tree->find_node((iter->first>>32), (iter->first&0xFFFFFFFF));
-									if (child != NULL&&child->timestamp<=min(lm_node->timestamp, iter->second))
-									{
-										child->edge_timestamp = iter->second;
-										child->timestamp = min(lm_node->timestamp, iter->second);
-										DF_tree->substitute_parent(lm_node, child);
-									}
+									child->edge_timestamp = iter->second;
+									child->timestamp = min(lm_node->timestamp, iter->second);
+									DF_tree->substitute_parent(lm_node, child);
 								}
 							}
 						}
@@ -1091,32 +1059,59 @@ public:
 				RPQ_tree* tree_pt = tmp->tree;
 				unsigned int root_ID = tree_pt->root->node_ID;
 				unsigned int root_state = tree_pt->root->state;
-				if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+				tree_node* node_pt = tree_pt->find_node(v, state);
+				if (node_pt)
 				{
-					if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end())
+					unsigned int df_edge_time = node_pt->timestamp;
+					if (tree_pt->root->state==0&&DF_forest.find(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)) == DF_forest.end())
 					{
-						unsigned int df_edge_time = tree_pt->node_map[state]->index[v]->timestamp;
-						if (tree_pt->root->state==0&&DF_forest.find(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)) == DF_forest.end())
+						RPQ_tree* DF_tree = new RPQ_tree(&node_pool);
+						tree_node* root = add_df_node(DF_tree, tree_pt->root->node_ID, tree_pt->root->state, tree_pt->root->node_ID, NULL, MAX_INT, MAX_INT);
+						DF_tree->root = root;
+						add_df_node(DF_tree, v, state, tree_pt->root->node_ID, root, df_edge_time, df_edge_time);
+						DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)] = DF_tree;
+					}
+						if (v2d_index.find(root_state) != v2d_index.end())
 						{
-							RPQ_tree* DF_tree = new RPQ_tree;
-							tree_node* root = add_df_node(DF_tree, tree_pt->root->node_ID, tree_pt->root->state, tree_pt->root->node_ID, NULL, MAX_INT, MAX_INT);
-							DF_tree->root = root;
-							add_df_node(DF_tree, v, state, tree_pt->root->node_ID, root, df_edge_time, df_edge_time);
-							DF_forest[merge_long_long(tree_pt->root->node_ID, tree_pt->root->state)] = DF_tree;
-						}
-							if (v2d_index.find(root_state) != v2d_index.end())
+							if (v2d_index[root_state]->tree_index.find(root_ID) != v2d_index[root_state]->tree_index.end())
 							{
-								if (v2d_index[root_state]->tree_index.find(root_ID) != v2d_index[root_state]->tree_index.end())
+								tree_info* DF_tmp = v2d_index[root_state]->tree_index[root_ID];
+								while (DF_tmp)
 								{
-									tree_info* DF_tmp = v2d_index[root_state]->tree_index[root_ID];
-									while (DF_tmp)
+									RPQ_tree* DF_tree = DF_tmp->tree;
+									tree_node* lm_node = DF_tree->find_node(v, state);
+									tree_node* parent = DF_tree->find_node(root_ID, root_state);
+									assert(parent);
+									if (!lm_node) {
+										lm_node = add_df_node(DF_tree, v, state, DF_tree->root->node_ID, parent, min(parent->timestamp, df_edge_time), df_edge_time);
+										unordered_set<unsigned long long> ancestors;
+										tree_node* cur = parent;
+										while (cur)
+										{
+											ancestors.insert(merge_long_long(cur->node_ID, cur->state));
+											cur = cur->parent;
+										}
+										for (unordered_map<unsigned long long, unsigned int>::iterator iter = successors.begin(); iter != successors.end(); iter++)
+										{
+											if (ancestors.find(iter->first) != ancestors.end())
+												continue;
+											tree_node* child = DF_tree->find_node((iter->first >> 32), (iter->first & 0xFFFFFFFF));
+											if (child != NULL && child->timestamp <= min(lm_node->timestamp, iter->second))
+											{
+												child->edge_timestamp = iter->second;
+												child->timestamp = min(lm_node->timestamp, iter->second);
+												DF_tree->substitute_parent(lm_node, child);
+											}
+										}
+									}
+									else
 									{
-										RPQ_tree* DF_tree = DF_tmp->tree;
-										tree_node* lm_node = DF_tree->find_node(v, state);
-										tree_node* parent = DF_tree->find_node(root_ID, root_state);
-										assert(parent);
-										if (!lm_node) {
-											lm_node = add_df_node(DF_tree, v, state, DF_tree->root->node_ID, parent, min(parent->timestamp, df_edge_time), df_edge_time);
+										lm_node = DF_tree->find_node(v, state);
+										if (lm_node->timestamp < min(parent->timestamp, df_edge_time))
+										{
+											lm_node->edge_timestamp = df_edge_time;
+											lm_node->timestamp = min(parent->timestamp, df_edge_time);
+											DF_tree->substitute_parent(parent, lm_node);
 											unordered_set<unsigned long long> ancestors;
 											tree_node* cur = parent;
 											while (cur)
@@ -1136,42 +1131,13 @@ public:
 													DF_tree->substitute_parent(lm_node, child);
 												}
 											}
+											ancestors.clear();
 										}
-										else
-										{
-											lm_node = DF_tree->find_node(v, state);
-											if (lm_node->timestamp < min(parent->timestamp, df_edge_time))
-											{
-												lm_node->edge_timestamp = df_edge_time;
-												lm_node->timestamp = min(parent->timestamp, df_edge_time);
-												DF_tree->substitute_parent(parent, lm_node);
-												unordered_set<unsigned long long> ancestors;
-												tree_node* cur = parent;
-												while (cur)
-												{
-													ancestors.insert(merge_long_long(cur->node_ID, cur->state));
-													cur = cur->parent;
-												}
-												for (unordered_map<unsigned long long, unsigned int>::iterator iter = successors.begin(); iter != successors.end(); iter++)
-												{
-													if (ancestors.find(iter->first) != ancestors.end())
-														continue;
-													tree_node* child = DF_tree->find_node((iter->first >> 32), (iter->first & 0xFFFFFFFF));
-													if (child != NULL && child->timestamp <= min(lm_node->timestamp, iter->second))
-													{
-														child->edge_timestamp = iter->second;
-														child->timestamp = min(lm_node->timestamp, iter->second);
-														DF_tree->substitute_parent(lm_node, child);
-													}
-												}
-												ancestors.clear();
-											}
-										}
-										DF_tmp = DF_tmp->next;
 									}
+									DF_tmp = DF_tmp->next;
 								}
 							}
-					}
+						}
 				}
 				tmp = tmp->next;
 			}
@@ -1179,7 +1145,7 @@ public:
 	}
 	RPQ_tree* build_lm_tree(unsigned int v, unsigned int state) // this function build new lm tree for a landmark, we use time info in prune and may miss some nodes, we will add them back with above fulfill_new_lm_tree later .
 	{
-		RPQ_tree* new_tree = new RPQ_tree;
+		RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 		new_tree->root = new_tree->add_node(v, state, NULL, MAX_INT, MAX_INT);
 		queue<tree_node*> q;
 		q.push(new_tree->root);
@@ -1196,31 +1162,29 @@ public:
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge);
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs);
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next())
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
 
-				if (new_tree->node_map.find(dst_state) == new_tree->node_map.end() || new_tree->node_map[dst_state]->index.find(successor) == new_tree->node_map[dst_state]->index.end())
+				if (new_tree->find_node(successor, dst_state) == NULL)
 				{
-					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, sucs[i].timestamp);
+					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, suc->timestamp);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = new_tree->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = new_tree->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time)
 					{
 						if (dst_pt->parent != tmp)
 							new_tree->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						q.push(dst_pt);
 					}
 				}
@@ -1296,15 +1260,15 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+					for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 					{
-						for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+						tree_node* node = lm_tree->node_map.table[i];
+						if (!node)
+							continue;
+						if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 						{
-							if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-							{
-								node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
-								// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
-							}
+							node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
+							// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
 						}
 					}
 					if (node_budget <= 0)
@@ -1334,14 +1298,14 @@ public:
 						tmp = tmp->next;
 						continue;
 					}
-					for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+					for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 					{
-						for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+						tree_node* node = lm_tree->node_map.table[i];
+						if (!node)
+							continue;
+						if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 						{
-							if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-							{
-								node_budget--;
-							}
+							node_budget--;
 						}
 					}
 					if (node_budget <= 0)
@@ -1444,22 +1408,22 @@ public:
 	{
 		vector<vertex_score> scores;
 		unordered_map<unsigned long long, unsigned int> score_map; //store scores of nodes
-		for (unordered_map<unsigned int, neighbor_list>::iterator iter = g->g.begin(); iter != g->g.end(); iter++)
+		const vector<unsigned int>& vertices = g->vertices_in_window();
+		for (unsigned int i = 0; i < vertices.size(); i++)
 		{
+			unsigned int id = vertices[i];
+			if (g->g[id].lists.empty()) // only vertices with out edges in the window are considered.
+				continue;
 			unsigned int degree_sum = 0;
-			unsigned int id = iter->first;
 			for (unordered_map<int, automat_edge*>::iterator iter2 = aut->g.begin(); iter2 != aut->g.end(); iter2++)
 			{
 				unsigned int state = iter2->first;
 				unsigned long long info = merge_long_long(id, state);
 				if (count_presence(id, state, 2)) {  // filter out product graph nodes which appear in less than 2 trees.
-					map<unsigned int, unsigned int> degree_map;
-					g->get_src_degree(id, degree_map);
 					degree_sum = 0;
 					automat_edge* tmp = iter2->second; // only include the edges with acceptable labels in degree counting.
 					while (tmp) {
-						if (degree_map.find(tmp->label) != degree_map.end())
-							degree_sum += degree_map[tmp->label];
+						degree_sum += g->get_src_degree(id, tmp->label); // the degree of each label is kept in the label list, no need to scan the neighbor list.
 						tmp = tmp->next;
 					}
 					if (degree_sum > 0)
@@ -1580,8 +1544,8 @@ public:
 	}
 	void output_match(ofstream& fout)
 	{
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
-			fout << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << iter->second << endl;
+		for (result_set::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
+			fout << g->external_id(iter->first >> 32) << " " << g->external_id(iter->first & 0xFFFFFFFF) << " " << iter->second << endl; // translate the internal vertex IDs back to the IDs in the stream.
 	}
 	void count(ofstream& fout) // count the memory used in the algorithm, but exclude the memory of automaton and streaming graph, because they are essential for any algorithm.
 	{
@@ -1589,13 +1553,13 @@ public:
 		unsigned int um_size = sizeof(unordered_map<unsigned int, unsigned int>); // size of statistics in a map, which does not change with the key-value type, usually is 56, but may change with the system.
 		unsigned int m_size = sizeof(map<unsigned int, unsigned int>); // size of pointers and statistics in a map, which does not change with the key-value type, usually is 48, but may change with the system.
 
-		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
-		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;
+		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
+		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;
 
 		cout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 		fout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 
-		unsigned int tree_size = 16 + m_size * 2 + us_size; // size of statistics and pointers in a tree
+		unsigned int tree_size = 16 + sizeof(tree_node_index) + m_size + us_size; // size of statistics and pointers in a tree, including the node map with its inline slots
 		double tree_memory = ((double)(um_size + forests.bucket_count() * 8 + forests.size() * (24 + tree_size)) / (1024 * 1024)); // forest is a unordered_map (um), each KV is 16 byte, 8 byte long long + 8 byte pointer,
 		// plus a pointer pointing to the next KV in the list. Each bucket has a pointer pointing to the head of the value list in this bucket. Memory of following us is computed similarly. size of statistics of each tree is also calculated here.
 		double DF_tree_memory = ((double)(um_size + DF_forest.bucket_count() * 8 + DF_forest.size() * (24 + tree_size)) / (1024 * 1024));
@@ -1610,18 +1574,13 @@ public:
 		{
 			RPQ_tree* tree_pt = iter->second;
 			lm_set_memory += tree_pt->timed_landmarks.bucket_count() * 8 + tree_pt->timed_landmarks.size() * 24;
-			time_info_memory += tree_pt->time_info.size() * 40; // first layer is a map, and each KV is 24 byte, 3 pointer is associated (parent, left child, right child)
-			for (map<unsigned int, time_info_index*>::iterator iter2 = tree_pt->time_info.begin(); iter2 != tree_pt->time_info.end(); iter2++) {
-				time_info_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * 16; // second layer is a um, and each KV is 8 byte.
-			}
+			time_info_memory += tree_pt->time_info.compute_memory(); // the TI map is a table of 12 byte slots, each slot stores a product graph node and its timestamp.
 			unsigned long long info = merge_long_long(tree_pt->root->node_ID, tree_pt->root->state);
 			bool lm_root = false;
 			if (landmarks.find(info) != landmarks.end())
 				lm_root = true; // marks if it is an LM tree
 			double node_memory = 0;
-			node_memory += tree_pt->node_map.size() * 40; // first layer of the node map is a map
-			for (map<unsigned int, tree_node_index*>::iterator iter2 = tree_pt->node_map.begin(); iter2 != tree_pt->node_map.end(); iter2++)
-				node_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * (24 + 48); // second layer is a um, each KV is 16 byte, memory of the tree node is also computed here.
+			node_memory += tree_pt->node_map.compute_memory() + tree_pt->node_map.size * sizeof(tree_node); // the node map is a flat table of pointers, memory of the tree node is also computed here.
 			if (lm_root)
 				lm_node_memory += node_memory;
 			else
@@ -1631,9 +1590,7 @@ public:
 		{
 			RPQ_tree* tree_pt = iter->second;	
 			double node_memory = 0;
-			node_memory += tree_pt->node_map.size() * 40; // first layer of the node map is a map
-			for (map<unsigned int, tree_node_index*>::iterator iter2 = tree_pt->node_map.begin(); iter2 != tree_pt->node_map.end(); iter2++)
-				node_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * (24 + 48); // second layer is a um, each KV is 16 byte, memory of the tree node is also computed here.
+			node_memory += tree_pt->node_map.compute_memory() + tree_pt->node_map.size * sizeof(tree_node); // the node map is a flat table of pointers, memory of the tree node is also computed here.
 			DF_node_memory += node_memory;
 		}
 		lm_set_memory = ((lm_set_memory) / (1024 * 1024));
@@ -1647,20 +1604,11 @@ public:
 		lm_node_memory += m_size + v2l_index.size() * 40; // firt layer is a map
 		for (map<unsigned int, lm_info_index*>::iterator iter = v2l_index.begin(); iter != v2l_index.end(); iter++)
 		{
-			lm_node_memory += um_size + m_size; // each second layer lm_info_index has a um and a map
+			lm_node_memory += um_size; // each second layer lm_info_index has a um, its info_map and pool are computed below
 			lm_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;  // memory of the um, each KV has 16 bytes.
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					lm_node_num++; // this is the reverse index unit number, as well as the number of nodes in LM trees.
-					tmp = tmp->next;
-				}
-			}
-			lm_node_memory += iter->second->info_map.size() * 48; // each KV of the map has size 24
+			lm_node_num += iter->second->info_map.size; // this is the reverse index unit number, as well as the number of nodes in LM trees.
+			lm_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		lm_node_memory += lm_node_num * 24; // memory of the reverse index units (tree_info)
 		lm_node_memory = (lm_node_memory / (1024 * 1024));
 		cout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
 		fout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
@@ -1670,20 +1618,11 @@ public:
 		tree_node_memory += m_size + v2t_index.size() * 40;
 		for (map<unsigned int, tree_info_index*>::iterator iter = v2t_index.begin(); iter != v2t_index.end(); iter++)
 		{
-			tree_node_memory += um_size + m_size;
+			tree_node_memory += um_size;
 			tree_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					tree_node_num++;
-					tmp = tmp->next;
-				}
-			}
-			tree_node_memory += iter->second->info_map.size() * 40;
+			tree_node_num += iter->second->info_map.size;
+			tree_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		tree_node_memory += tree_node_num * 24;
 		tree_node_memory = (tree_node_memory / (1024 * 1024));
 		cout << "node number in normal tree: " << tree_node_num << ", memory: " << tree_node_memory << endl;
 		fout << "node number in normal tree: " << tree_node_num << ", memory: " << tree_node_memory << endl;
@@ -1692,20 +1631,11 @@ public:
 		DF_node_memory += m_size + v2d_index.size() * 40;
 		for (map<unsigned int, tree_info_index*>::iterator iter = v2d_index.begin(); iter != v2d_index.end(); iter++)
 		{
-			DF_node_memory += um_size + m_size;
+			DF_node_memory += um_size;
 			DF_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					DF_node_num++;
-					tmp = tmp->next;
-				}
-			}
-			DF_node_memory += iter->second->info_map.size() * 40;
+			DF_node_num += iter->second->info_map.size;
+			DF_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		DF_node_memory += DF_node_num * 24;
 		DF_node_memory = (DF_node_memory / (1024 * 1024));
 		cout << "node number in dependency tree: " << DF_node_num << ", memory: " << DF_node_memory << endl;
 		cout << "total memory besides result set: " << (tree_memory + global_lm_memory + lm_set_memory + time_info_memory + lm_node_memory + tree_node_memory + DF_tree_memory + DF_node_memory) << endl;
@@ -1717,23 +1647,14 @@ public:
 
 	void results_update(int time) // this function deletes out dated results with timestamp smaller than given time
 	{
-		if (time <= 0)
-			return;
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end();)
-		{
-			if (iter->second < time) {
-				iter = result_pairs.erase(iter);
-			}
-			else
-				iter++;
-		}
-		shrink(result_pairs);
+		result_pairs.expire(time); // only the calendar buckets older than the threshold are visited.
 	}
 
 	void erase_tree_node(RPQ_tree* tree_pt, tree_node* child, unordered_set<unsigned long long>& expired_de)  // this function deletes subtree rooted at the given node (child) in a normal tree (tree_pt)
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1747,14 +1668,16 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void erase_df_tree_node(RPQ_tree* tree_pt, tree_node* child)  // this function deletes subtree rooted at the given node (child) in a normal tree (tree_pt)
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1764,8 +1687,9 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_df_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void erase_lm_tree_node(RPQ_tree* tree_pt, tree_node* child, unordered_set<unsigned long long>& expired_de) // this function deletes subtree rooted at the given node (child) in an LM tree (tree_pt), different from above,
@@ -1773,6 +1697,7 @@ public:
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1786,46 +1711,39 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_lm_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID, tree_pt->root->state);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void expire_per_lm_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time, unordered_set<unsigned long long>& expired_de) // carry out expiration in an LM tree tree_pt given a possibly expired node (v, state) and tail of sliding window expired_time. 
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
-					erase_lm_tree_node(tree_pt, dst_pt, expired_de);
-				}
+			if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
+				erase_lm_tree_node(tree_pt, dst_pt, expired_de);
 			}
 		}
 	}
 
 	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time, unordered_set<unsigned long long>& expired_de) // expire in normal tree, we only need to delte the nodes in the subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time)
-					erase_tree_node(tree_pt, dst_pt, expired_de);
-			}
-
+			if (dst_pt->timestamp < expired_time)
+				erase_tree_node(tree_pt, dst_pt, expired_de);
 		}
 	}
 
 	void expire_per_df_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // expire in normal tree, we only need to delte the nodes in the subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time)
-					erase_df_tree_node(tree_pt, dst_pt);
-			}
-
+			if (dst_pt->timestamp < expired_time)
+				erase_df_tree_node(tree_pt, dst_pt);
 		}
 	}
 
@@ -1841,8 +1759,7 @@ public:
 		{
 			unsigned int dst = deleted_edges[i].d;
 			unsigned int label = deleted_edges[i].label;
-			vector<pair<int, int>> vec;
-			aut->get_possible_state(label, vec); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
+			const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
 			for (int j = 0; j < vec.size(); j++) {
 				int dst_state = vec[j].second;
 				if (dst_state == -1)
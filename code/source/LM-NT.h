@@ -24,15 +24,17 @@ public:
 	streaming_graph* g; // pointer to the streaming graph
 	automaton* aut;// pointer to the DFA generated by the regular expression
 	map<unsigned int, double> aut_scores; // this map stores the depth we estimated for each state in the DFA
+	tree_node_pool node_pool; // memory of the tree nodes of this forest, shared by all its trees.
 	unordered_map<unsigned long long, RPQ_tree*> forests; // unordered map that maps each vertex ID-state pair to the spanning tree rooted at it. the vertex ID and the state is merged into an Unsigned long long 
 	map<unsigned int, tree_info_index*> v2t_index; // Maps each state to a tree_info_index, reverse index that maps a graph vertex to the normal trees that contains it.
 	map<unsigned int, lm_info_index*> v2l_index; // Maps each state to a lm_info_index, reverse index that maps a graph vertex to the LM trees that contains it.
-	unordered_map<unsigned long long, unsigned int> result_pairs;
+	result_set result_pairs;
 	unordered_set<unsigned long long> landmarks; // set of landmarks, vertex ID and states are merged.
 
 	LM_NT(streaming_graph* g_, automaton* automaton)
 	{
 		g = g_;
+		result_pairs.g = g_;
 		aut = automaton;
 	}
 	~LM_NT()
@@ -65,10 +67,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -81,10 +80,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -252,28 +248,23 @@ public:
 						unsigned int parent_ID = tree_pt->root->node_ID;
 						unsigned int parent_state = tree_pt->root->state;
 						unsigned long long parent = merge_long_long(parent_ID, parent_state);
-						if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+						tree_node* node_pt = tree_pt->find_node(ID, state);
+						if (node_pt)
 						{
-							if (tree_pt->node_map[state]->index.find(ID) != tree_pt->node_map[state]->index.end())
-							{
-								tree_node* node_pt = tree_pt->node_map[state]->index[ID];
-								unsigned int local_path_time = node_pt->timestamp;
-								unsigned int parent_time = min(time, local_path_time);
-								if (time_index.find(parent) == time_index.end()) {
-									time_index[parent] = parent_time;
-									if (parent_state == 0)
-										reachable_initial_nodes[parent] = parent_time;
-									q.push(make_pair(parent, parent_time));
-								}
-								else if (time_index[parent] < parent_time) {
-									time_index[parent] = parent_time;
-									if (parent_state == 0)
-										reachable_initial_nodes[parent] = parent_time;
-									q.push(make_pair(parent, parent_time));
-								}
+							unsigned int local_path_time = node_pt->timestamp;
+							unsigned int parent_time = min(time, local_path_time);
+							if (time_index.find(parent) == time_index.end()) {
+								time_index[parent] = parent_time;
+								if (parent_state == 0)
+									reachable_initial_nodes[parent] = parent_time;
+								q.push(make_pair(parent, parent_time));
+							}
+							else if (time_index[parent] < parent_time) {
+								time_index[parent] = parent_time;
+								if (parent_state == 0)
+									reachable_initial_nodes[parent] = parent_time;
+								q.push(make_pair(parent, parent_time));
 							}
-							else
-								cout << "error! non existent landmark " << endl;
 						}
 						else
 							cout << "error! non existent landmark " << endl;
@@ -293,20 +284,15 @@ public:
 						unsigned int parent_ID = tree_pt->root->node_ID;
 						unsigned int parent_state = tree_pt->root->state;
 						unsigned long long parent = merge_long_long(parent_ID, parent_state);
-						if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+						tree_node* node_pt = tree_pt->find_node(ID, state);
+						if (node_pt)
 						{
-							if (tree_pt->node_map[state]->index.find(ID) != tree_pt->node_map[state]->index.end())
-							{
-								tree_node* node_pt = tree_pt->node_map[state]->index[ID];
-								unsigned int local_path_time = node_pt->timestamp;
-								unsigned int parent_time = min(time, local_path_time);
-								if (reachable_initial_nodes.find(parent) == reachable_initial_nodes.end()) // for normal trees, we do not need to use time_index to record the timestamps of dependency paths to them, as 
-									reachable_initial_nodes[parent] = parent_time;
-								else if (reachable_initial_nodes[parent] < parent_time)
-									reachable_initial_nodes[parent] = parent_time;
-							}
-							else
-								cout << "error! non existent landmark " << endl;
+							unsigned int local_path_time = node_pt->timestamp;
+							unsigned int parent_time = min(time, local_path_time);
+							if (reachable_initial_nodes.find(parent) == reachable_initial_nodes.end()) // for normal trees, we do not need to use time_index to record the timestamps of dependency paths to them, as 
+								reachable_initial_nodes[parent] = parent_time;
+							else if (reachable_initial_nodes[parent] < parent_time)
+								reachable_initial_nodes[parent] = parent_time;
 						}
 						else
 							cout << "error! non existent landmark " << endl;
@@ -340,34 +326,32 @@ public:
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs); // get out edges of the src node
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // get out edges of the src node
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // if this node does not exist yet.
+				if (tree_pt->find_node(successor, dst_state) == NULL) // if this node does not exist yet.
 				{
 					tree_node* new_node;
 					if (if_lm_tree)
-						new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, sucs[i].timestamp);
+						new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, suc->timestamp);
 					else
-						new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, sucs[i].timestamp);
+						new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
 					{
 						if (dst_pt->parent != tmp)
 							tree_pt->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						q.push(dst_pt);
 					}
 				}
@@ -385,17 +369,16 @@ public:
 		unsigned int root_ID = lm_tree->root->node_ID;
 		unsigned int root_state = lm_tree->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(lm_tree->node_map.find(src_state) != lm_tree->node_map.end());
-		assert(lm_tree->node_map[src_state]->index.find(s) != lm_tree->node_map[src_state]->index.end());
-		tree_node* src_pt = lm_tree->node_map[src_state]->index[s];
+		assert(lm_tree->find_node(s, src_state) != NULL);
+		tree_node* src_pt = lm_tree->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 
 		tree_node* dst_pt = NULL;
-		if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.find(d) == lm_tree->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (lm_tree->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_lm_node(lm_tree, d, dst_state, lm_tree->root->node_ID, lm_tree->root->state, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { // else the new timestamp must be larger than the existing timestamp of dst node in this tree, otherwise we should have returned in the above check.
-			dst_pt = lm_tree->node_map[dst_state]->index[d];
+			dst_pt = lm_tree->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -419,18 +402,17 @@ public:
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
-		assert(tree_pt->node_map.find(src_state) != tree_pt->node_map.end());
-		assert(tree_pt->node_map[src_state]->index.find(s) != tree_pt->node_map[src_state]->index.end());
-		tree_node* src_pt = tree_pt->node_map[src_state]->index[s];
+		assert(tree_pt->find_node(s, src_state) != NULL);
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 		unordered_map<unsigned int, unsigned int> updated_nodes;
 
 		tree_node* dst_pt = NULL;
-		if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (tree_pt->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { // else the new timestamp must be larger than the existing timestamp of dst node in this tree, otherwise we should have returned in the above check.
-			dst_pt = tree_pt->node_map[dst_state]->index[d];
+			dst_pt = tree_pt->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -452,17 +434,14 @@ public:
 		if (forests.find(info) != forests.end())
 		{
 			RPQ_tree* tree_pt = forests[info];
-			for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+			for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 			{
-				if (aut->check_final_state(iter->first))
-				{
-					for (unordered_map<unsigned int, tree_node*>::iterator node_iter = iter->second->index.begin(); node_iter != iter->second->index.end(); node_iter++)
-					{
-						unsigned int time = node_iter->second->timestamp;
-						if (final_nodes.find(node_iter->first) == final_nodes.end() || final_nodes[node_iter->first] < time)
-							final_nodes[node_iter->first] = time;
-					}
-				}
+				tree_node* node = tree_pt->node_map.table[i];
+				if (!node || !aut->check_final_state(node->state))
+					continue;
+				unsigned int time = node->timestamp;
+				if (final_nodes.find(node->node_ID) == final_nodes.end() || final_nodes[node->node_ID] < time)
+					final_nodes[node->node_ID] = time;
 			}
 		}
 	}
@@ -474,18 +453,19 @@ public:
 	{
 		if (aut->acceptable_labels.find(label) == aut->acceptable_labels.end()) // we only insert the edge if the automaton can accept it, in this case the streaming graph is a layer graph containing necessray edges. 
 			return;
+		s = g->vertex_id(s); // the forests work on internal vertex IDs of the streaming graph.
+		d = g->vertex_id(d);
 		g->insert_edge(s, d, label, timestamp);
 		if (aut->get_suc(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end()) // we need to build a new tree
 		{
-			RPQ_tree* new_tree = new RPQ_tree();
+			RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 			if (landmarks.find(merge_long_long(s, 0)) == landmarks.end()) // a normal tree
 				new_tree->root = add_node(new_tree, s, 0, s, NULL, MAX_INT, MAX_INT);
 			else // an LM tree
 				new_tree->root = add_lm_node(new_tree, s, 0, s, 0, NULL, MAX_INT, MAX_INT);
 			forests[merge_long_long(s, 0)] = new_tree;
 		}
-		vector<pair<int, int> >vec;
-		aut->get_possible_state(label, vec); // find all the state paris that can accept this label
+		const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // find all the state paris that can accept this label
 		for (unsigned int i = 0; i < vec.size(); i++) {
 			unsigned int src_state = vec[i].first;
 			unsigned int dst_state = vec[i].second;
@@ -629,34 +609,32 @@ public:
 
                         map<int, int> aut_edge;
                         aut->get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-                        vector<edge_info>sucs;
-                        g->get_timed_all_suc(tmp->node_ID, sucs); // get out edges of the src node
-                        for (int i = 0; i < sucs.size(); i++)
+                        for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // get out edges of the src node
                         {
-                                unsigned int successor = sucs[i].d;
-                                unsigned int label = sucs[i].label;
-                                unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+                                unsigned int successor = suc->d;
+                                unsigned int label = suc->label;
+                                unsigned int time = min(tmp->timestamp, suc->timestamp);
                                 if (aut_edge.find(label) == aut_edge.end())
                                         continue;
                                 int dst_state = aut_edge[label];
-                                if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // if this node does not exist yet.
+                                if (tree_pt->find_node(successor, dst_state) == NULL) // if this node does not exist yet.
                                 {
                                         tree_node* new_node;
                                         if (lm_expand_tree)
-                                                new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, sucs[i].timestamp);
+                                                new_node = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, tmp, time, suc->timestamp);
                                         else
-                                                new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, sucs[i].timestamp);
+                                                new_node = add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp);
                                         q.push(new_node);
                                 }
                                 else
                                 {
-                                        tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+                                        tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
                                         if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
                                         {
                                                 if (dst_pt->parent != tmp)
                                                         tree_pt->substitute_parent(tmp, dst_pt);
                                                 dst_pt->timestamp = time;
-                                                dst_pt->edge_timestamp = sucs[i].timestamp;
+                                                dst_pt->edge_timestamp = suc->timestamp;
                                                 q.push(dst_pt);
                                         }
                                 }
@@ -670,13 +648,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_index(iter2->first, iter2->second->state, root_ID);
-				add_lm_index(tree_pt, iter2->first, iter2->second->state, root_ID, root_state);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_index(node->node_ID, node->state, root_ID);
+			add_lm_index(tree_pt, node->node_ID, node->state, root_ID, root_state);
 		}
 	}
 
@@ -684,13 +662,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_lm_index(iter2->first, iter2->second->state, root_ID, root_state);
-				add_index(tree_pt, iter2->first, iter2->second->state, root_ID);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_lm_index(node->node_ID, node->state, root_ID, root_state);
+			add_index(tree_pt, node->node_ID, node->state, root_ID);
 		}
 	}
 	void recover_subtree(unsigned int v, unsigned int state, RPQ_tree* lm_tree) // this function recovers the subtrees of a deleted landmark (v, state) in normal trees, lm_tree is the LM tree of this landmark.
@@ -761,6 +739,8 @@ public:
 					lm_node->lm = true;
 					tree_node* child = lm_node->child;  // carry out a BFS starting from childs of this landmark, and delete all the succesors in its subtree.
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
+					unsigned int node_num = 0;
 					queue<tree_node*> q;
 					while (child)
 					{
@@ -778,20 +758,15 @@ public:
 							q.push(child);
 							child = child->brother;
 						}
-						assert(tree_pt->node_map.find(cur->state) != tree_pt->node_map.end());
-						tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-						shrink(tree_pt->node_map[cur->state]->index);
-						if (tree_pt->node_map[cur->state]->index.empty()) {
-							delete tree_pt->node_map[cur->state];
-							tree_pt->node_map.erase(cur->state);
-						}
+						tree_pt->node_map.erase(cur->node_ID, cur->state);
 						if (cur->lm) {
 							tree_pt->timed_landmarks.erase(merge_long_long(cur->node_ID, cur->state));
 							shrink(tree_pt->timed_landmarks);
 						}
-						delete cur;
+						node_num++;
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, node_num);
 					tmp = tmp->next;
 				}
 			}
@@ -819,6 +794,8 @@ public:
 					lm_node->lm = true;
 					tree_node* child = lm_node->child;
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
+					unsigned int node_num = 0;
 					queue<tree_node*> q;
 					while (child)
 					{
@@ -837,19 +814,15 @@ public:
 							child = child->brother;
 						}
 
-						tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-						shrink(tree_pt->node_map[cur->state]->index);
-						if (tree_pt->node_map[cur->state]->index.empty()) {
-							delete tree_pt->node_map[cur->state];
-							tree_pt->node_map.erase(cur->state);
-						}
+						tree_pt->node_map.erase(cur->node_ID, cur->state);
 						if (cur->lm) {
 							tree_pt->timed_landmarks.erase(merge_long_long(cur->node_ID, cur->state));
 							shrink(tree_pt->timed_landmarks);
 						}
-						delete cur;
+						node_num++;
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, node_num);
 					tmp = tmp->next;
 				}
 			}
@@ -858,7 +831,7 @@ public:
 	}
 	RPQ_tree* build_lm_tree(unsigned int v, unsigned int state) // this function build new lm tree for a landmark, we use time info in prune and may miss some nodes, we will add them back with above fulfill_new_lm_tree later .
 	{
-		RPQ_tree* new_tree = new RPQ_tree;
+		RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 		new_tree->root = new_tree->add_node(v, state, NULL, MAX_INT, MAX_INT);
 		queue<tree_node*> q;
 		q.push(new_tree->root);
@@ -875,31 +848,29 @@ public:
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge);
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs);
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next())
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
 
-				if (new_tree->node_map.find(dst_state) == new_tree->node_map.end() || new_tree->node_map[dst_state]->index.find(successor) == new_tree->node_map[dst_state]->index.end())
+				if (new_tree->find_node(successor, dst_state) == NULL)
 				{
-					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, sucs[i].timestamp);
+					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, suc->timestamp);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = new_tree->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = new_tree->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time)
 					{
 						if (dst_pt->parent != tmp)
 							new_tree->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						q.push(dst_pt);
 					}
 				}
@@ -975,15 +946,15 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+					for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 					{
-						for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+						tree_node* node = lm_tree->node_map.table[i];
+						if (!node)
+							continue;
+						if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 						{
-							if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-							{
-								node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
-								// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
-							}
+							node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
+							// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
 						}
 					}
 					if (node_budget <= 0)
@@ -1013,14 +984,14 @@ public:
 						tmp = tmp->next;
 						continue;
 					}
-					for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+					for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 					{
-						for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+						tree_node* node = lm_tree->node_map.table[i];
+						if (!node)
+							continue;
+						if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 						{
-							if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-							{
-									node_budget--;
-							}
+								node_budget--;
 						}
 					}
 					if (node_budget <= 0)
@@ -1124,22 +1095,22 @@ public:
 	{
 		vector<vertex_score> scores;
 		unordered_map<unsigned long long, unsigned int> score_map; //store scores of nodes
-		for (unordered_map<unsigned int, neighbor_list>::iterator iter = g->g.begin(); iter != g->g.end(); iter++)
+		const vector<unsigned int>& vertices = g->vertices_in_window();
+		for (unsigned int i = 0; i < vertices.size(); i++)
 		{
+			unsigned int id = vertices[i];
+			if (g->g[id].lists.empty()) // only vertices with out edges in the window are considered.
+				continue;
 			unsigned int degree_sum = 0;
-			unsigned int id = iter->first;
 			for (unordered_map<int, automat_edge*>::iterator iter2 = aut->g.begin(); iter2 != aut->g.end(); iter2++)
 			{
 				unsigned int state = iter2->first;
 				unsigned long long info = merge_long_long(id, state);
 				if (count_presence(id, state, 2)) {  // filter out product graph nodes which appear in less than 2 trees.
-					map<unsigned int, unsigned int> degree_map;
-					g->get_src_degree(id, degree_map);
 					degree_sum = 0;
 					automat_edge* tmp = iter2->second; // only include the edges with acceptable labels in degree counting.
 					while (tmp) {
-						if (degree_map.find(tmp->label) != degree_map.end())
-							degree_sum += degree_map[tmp->label];
+						degree_sum += g->get_src_degree(id, tmp->label); // the degree of each label is kept in the label list, no need to scan the neighbor list.
 						tmp = tmp->next;
 					}
 					if (degree_sum > 0)
@@ -1159,7 +1130,7 @@ public:
 
 
 		unsigned int num = scores.size() * candidate_rate;
-		double bar = scores[scores.size() - num].score; // nodes with score smaller than this bar is not in the candidate set.
+		double bar = num ? scores[scores.size() - num].score : scores.back().score + 1; // nodes with score smaller than this bar is not in the candidate set. With less than 1 / candidate_rate scored nodes the candidate set is empty.
 
 		for (unordered_set<unsigned long long>::iterator it = landmarks.begin(); it != landmarks.end(); ) // check current landmarks
 		{
@@ -1254,8 +1225,8 @@ public:
 	}
 	void output_match(ofstream& fout)
 	{
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
-			fout << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << iter->second << endl;
+		for (result_set::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
+			fout << g->external_id(iter->first >> 32) << " " << g->external_id(iter->first & 0xFFFFFFFF) << " " << iter->second << endl; // translate the internal vertex IDs back to the IDs in the stream.
 	}
 	void count(ofstream& fout) // count the memory used in the algorithm, but exclude the memory of automaton and streaming graph, because they are essential for any algorithm.
 	{
@@ -1263,13 +1234,13 @@ public:
 		unsigned int um_size = sizeof(unordered_map<unsigned int, unsigned int>); // size of statistics in a map, which does not change with the key-value type, usually is 56, but may change with the system.
 		unsigned int m_size = sizeof(map<unsigned int, unsigned int>); // size of pointers and statistics in a map, which does not change with the key-value type, usually is 48, but may change with the system.
 
-		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
-		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;
+		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
+		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;
 
 		cout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 		fout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 
-		unsigned int tree_size = 16 + m_size * 2 + us_size; // size of statistics and pointers in a tree
+		unsigned int tree_size = 16 + sizeof(tree_node_index) + m_size + us_size; // size of statistics and pointers in a tree, including the node map with its inline slots
 		double tree_memory = ((double)(um_size + forests.bucket_count() * 8 + forests.size() * (24 + tree_size)) / (1024 * 1024)); // forest is a unordered_map (um), each KV is 16 byte, 8 byte long long + 8 byte pointer,
 		// plus a pointer pointing to the next KV in the list. Each bucket has a pointer pointing to the head of the value list in this bucket. Memory of following us is computed similarly. size of statistics of each tree is also calculated here.
 		double global_lm_memory = ((double)(us_size + landmarks.size() * 16 + landmarks.bucket_count() * 8) / (1024 * 1024)); // size of the unordered_set (us) landmarks, each value is a 8 byte long long, associated with a pointer pointing to next value in the list.
@@ -1282,18 +1253,13 @@ public:
 		{
 			RPQ_tree* tree_pt = iter->second;
 			lm_set_memory += tree_pt->timed_landmarks.bucket_count() * 8 + tree_pt->timed_landmarks.size() * 24;
-			time_info_memory += tree_pt->time_info.size() * 40; // first layer is a map, and each KV is 24 byte, 3 pointer is associated (parent, left child, right child)
-			for (map<unsigned int, time_info_index*>::iterator iter2 = tree_pt->time_info.begin(); iter2 != tree_pt->time_info.end(); iter2++) {
-				time_info_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * 16; // second layer is a um, and each KV is 8 byte.
-			}
+			time_info_memory += tree_pt->time_info.compute_memory(); // the TI map is a table of 12 byte slots, each slot stores a product graph node and its timestamp.
 			unsigned long long info = merge_long_long(tree_pt->root->node_ID, tree_pt->root->state);
 			bool lm_root = false;
 			if (landmarks.find(info) != landmarks.end())
 				lm_root = true; // marks if it is an LM tree
 			double node_memory = 0;
-			node_memory += tree_pt->node_map.size() * 40; // first layer of the node map is a map
-			for (map<unsigned int, tree_node_index*>::iterator iter2 = tree_pt->node_map.begin(); iter2 != tree_pt->node_map.end(); iter2++)
-				node_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * (24 + 48); // second layer is a um, each KV is 16 byte, memory of the tree node is also computed here.
+			node_memory += tree_pt->node_map.compute_memory() + tree_pt->node_map.size * sizeof(tree_node); // the node map is a flat table of pointers, memory of the tree node is also computed here.
 			if (lm_root)
 				lm_node_memory += node_memory;
 			else
@@ -1310,20 +1276,11 @@ public:
 		lm_node_memory += m_size + v2l_index.size() * 40; // firt layer is a map
 		for (map<unsigned int, lm_info_index*>::iterator iter = v2l_index.begin(); iter != v2l_index.end(); iter++)
 		{
-			lm_node_memory += um_size + m_size; // each second layer lm_info_index has a um and a map
+			lm_node_memory += um_size; // each second layer lm_info_index has a um, its info_map and pool are computed below
 			lm_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;  // memory of the um, each KV has 16 bytes.
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					lm_node_num++; // this is the reverse index unit number, as well as the number of nodes in LM trees.
-					tmp = tmp->next;
-				}
-			}
-			lm_node_memory += iter->second->info_map.size() * 48; // each KV of the map has size 24
+			lm_node_num += iter->second->info_map.size; // this is the reverse index unit number, as well as the number of nodes in LM trees.
+			lm_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		lm_node_memory += lm_node_num * 24; // memory of the reverse index units (tree_info)
 		lm_node_memory = (lm_node_memory / (1024 * 1024));
 		cout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
 		fout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
@@ -1333,20 +1290,11 @@ public:
 		tree_node_memory += m_size + v2t_index.size() * 40;
 		for (map<unsigned int, tree_info_index*>::iterator iter = v2t_index.begin(); iter != v2t_index.end(); iter++)
 		{
-			tree_node_memory += um_size + m_size;
+			tree_node_memory += um_size;
 			tree_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					tree_node_num++;
-					tmp = tmp->next;
-				}
-			}
-			tree_node_memory += iter->second->info_map.size() * 40;
+			tree_node_num += iter->second->info_map.size;
+			tree_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		tree_node_memory += tree_node_num * 24;
 		tree_node_memory = (tree_node_memory / (1024 * 1024));
 		cout << "node number in normal tree: " << tree_node_num << ", memory: " << tree_node_memory << endl;
 		cout << "total memory besides result set: " << (tree_memory + global_lm_memory + lm_set_memory + time_info_memory + lm_node_memory + tree_node_memory) << endl;
@@ -1358,23 +1306,14 @@ public:
 
 	void results_update(int time) // this function deletes out dated results with timestamp smaller than given time
 	{
-		if (time <= 0)
-			return;
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end();)
-		{
-			if (iter->second < time) {
-				iter = result_pairs.erase(iter);
-			}
-			else
-				iter++;
-		}
-		shrink(result_pairs);
+		result_pairs.expire(time); // only the calendar buckets older than the threshold are visited.
 	}
 
 	void erase_tree_node(RPQ_tree* tree_pt, tree_node* child)  // this function deletes subtree rooted at the given node (child) in a normal tree (tree_pt)
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1384,8 +1323,9 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void erase_lm_tree_node(RPQ_tree* tree_pt, tree_node* child) // this function deletes subtree rooted at the given node (child) in an LM tree (tree_pt), different from above,
@@ -1393,6 +1333,7 @@ public:
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1402,33 +1343,29 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_lm_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID, tree_pt->root->state);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void expire_per_lm_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // carry out expiration in an LM tree tree_pt given a possibly expired node (v, state) and tail of sliding window expired_time. 
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
-					erase_lm_tree_node(tree_pt, dst_pt);
-				}
+			if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
+				erase_lm_tree_node(tree_pt, dst_pt);
 			}
 		}
 	}
 
 	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // expire in normal tree, we only need to delte the nodes in the subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time)
-					erase_tree_node(tree_pt, dst_pt);
-			}
-
+			if (dst_pt->timestamp < expired_time)
+				erase_tree_node(tree_pt, dst_pt);
 		}
 	}
 
@@ -1443,8 +1380,7 @@ public:
 		{
 			unsigned int dst = deleted_edges[i].d;
 			unsigned int label = deleted_edges[i].label;
-			vector<pair<int, int>> vec;
-			aut->get_possible_state(label, vec); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
+			const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
 			for (int j = 0; j < vec.size(); j++) {
 				int dst_state = vec[j].second;
 				if (dst_state == -1)
@@ -24,15 +24,18 @@ public:
 	streaming_graph* g; // pointer to the streaming graph
 	automaton* aut;// pointer to the DFA generated by the regular expression
 	map<unsigned int, double> aut_scores; // this map stores the depth we estimated for each state in the DFA
+	tree_node_pool node_pool; // memory of the tree nodes of this forest, shared by all its trees.
 	unordered_map<unsigned long long, RPQ_tree*> forests; // unordered map that maps each vertex ID-state pair to the spanning tree rooted at it. the vertex ID and the state is merged into an Unsigned long long 
 	map<unsigned int, tree_info_index*> v2t_index; // Maps each state to a tree_info_index, reverse index that maps a graph vertex to the normal trees that contains it.
 	map<unsigned int, lm_info_index*> v2l_index; // Maps each state to a lm_info_index, reverse index that maps a graph vertex to the LM trees that contains it.
-	unordered_map<unsigned long long, unsigned int> result_pairs;
+	result_set result_pairs;
+	unsigned int forest_epoch = 1; // increased whenever a tree is added to or deleted from the forest, the landmark handles cached in the normal trees are rebuilt after that.
 	unordered_set<unsigned long long> landmarks; // set of landmarks, vertex ID and states are merged.
 
 	LM_random(streaming_graph* g_, automaton* automaton)
 	{
 		g = g_;
+		result_pairs.g = g_;
 		aut = automaton;
 	}
 	~LM_random()
@@ -65,10 +68,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -81,10 +81,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -148,6 +145,8 @@ public:
 	}
 
 
+	vector<time_info_entry> merge_delta; // nodes updated by the last TI map merge, kept between calls to reuse the memory.
+
 	void lm_expand_in_lm_subtree(unsigned int lm, unsigned int state, RPQ_tree* root_lm_tree, unsigned int lm_time, unordered_map<unsigned long long, unsigned int>& updated_nodes)
 		// this function is called when a landmark (lm, state) is added into another lm tree root_lm_tree, the timestamp of this node is lm_time, we scan the LM tree of this landmark and update the time_info map
 		// in root_lm_tree, besides, we record the nodes where the timestamp in the time_info map of root_lm_tree is updated with updated_nodes, we need to update the result set in the upper layer with these nodes.
@@ -156,28 +155,12 @@ public:
 		if (forests.find(lm_info) == forests.end())
 			return;
 		RPQ_tree* lm_subtree = forests[lm_info]; // find the LM tree
-		for (map<unsigned int, time_info_index*>::iterator state_iter = lm_subtree->time_info.begin(); state_iter != lm_subtree->time_info.end(); state_iter++) { // scan its time info map
-			time_info_index* subtree_index = state_iter->second;
-			if (root_lm_tree->time_info.find(state_iter->first) == root_lm_tree->time_info.end()) // if this state is not in the time info map of root_lm_tree yet, add a new lm_info_index
-				root_lm_tree->time_info[state_iter->first] = new time_info_index;
-			time_info_index* root_index = root_lm_tree->time_info[state_iter->first];
-			for (unordered_map<unsigned int, unsigned int>::iterator iter = subtree_index->index.begin(); iter != subtree_index->index.end(); iter++)
-			{
-				unsigned int time = min(lm_time, iter->second); // compute the time of latest path from root of root_lm_tree to the node
-				if (root_index->index.find(iter->first) == root_index->index.end())
-				{
-					root_index->index[iter->first] = time;
-					updated_nodes[merge_long_long(iter->first, state_iter->first)] = time;
-				}
-				else {
-					if (root_index->index[iter->first] < time)	// if the node is not in the time info map of root_lm_tree before or has a smaller timestamp, we need to update it.
-					{
-						root_index->index[iter->first] = time;
-						updated_nodes[merge_long_long(iter->first, state_iter->first)] = time;
-					}
-				}
-			}
-		}
+		merge_delta.clear();
+		root_lm_tree->time_info.merge(lm_subtree->time_info, lm_time, &merge_delta); // merge its time info map into root_lm_tree, the time of latest path from root of root_lm_tree to a node passing the landmark is capped by lm_time,
+		// and a node is updated if it is not in the time info map of root_lm_tree before or has a smaller timestamp.
+		updated_nodes.reserve(updated_nodes.size() + merge_delta.size());
+		for (unsigned int i = 0; i < merge_delta.size(); i++)
+			updated_nodes[merge_delta[i].node] = merge_delta[i].time;
 	}
 
 	void lm_expand(tree_node* expand_node, RPQ_tree* lm_tree, unordered_map<unsigned long long, unsigned int>& updated_nodes)
@@ -204,35 +187,33 @@ public:
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs); // get out edges of the src node
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // get out edges of the src node
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
 
 				if (lm_tree->get_time_info(successor, dst_state) >= time) // prune the branch if there is already a path with no smaller timestamp
 					continue;
-				if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.find(successor) == lm_tree->node_map[dst_state]->index.end()) // if this node does not exist yet.
+				if (lm_tree->find_node(successor, dst_state) == NULL) // if this node does not exist yet.
 				{
-					tree_node* new_node = add_lm_node(lm_tree, successor, dst_state, lm_tree->root->node_ID, lm_tree->root->state, tmp, time, sucs[i].timestamp);
+					tree_node* new_node = add_lm_node(lm_tree, successor, dst_state, lm_tree->root->node_ID, lm_tree->root->state, tmp, time, suc->timestamp);
 					lm_tree->add_time_info(successor, dst_state, time); // add this new node and upadte the time info map
 					updated_nodes[merge_long_long(successor, dst_state)] = time;
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = lm_tree->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = lm_tree->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
 					{
 						if (dst_pt->parent != tmp)
 							lm_tree->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						lm_tree->add_time_info(successor, dst_state, time);
 						updated_nodes[merge_long_long(successor, dst_state)] = time;
 						q.push(dst_pt);
@@ -242,68 +223,105 @@ public:
 		}
 	}
 
+	struct back_track_frame // a level of the backward search, the LM trees containing landmark (lm, state) are visited one by one from cur.
+	{
+		unsigned int lm;
+		unsigned int state;
+		unsigned int src_time;
+		unsigned int dst_time;
+		tree_info* cur; // the LM tree being visited
+		bool started; // whether cur has been visited, the next tree is taken after the deeper levels started from cur are finished.
+	};
+	vector<back_track_frame> back_track_stack; // work stack of back_track_lm, kept between calls to reuse the memory.
+	vector<vector<pair<unsigned long long, unsigned int> > > back_track_nodes; // back_track_nodes[i] stores the updated nodes of level i of the work stack, also reused between calls.
+
 	void back_track_lm(unsigned int lm, unsigned int state, unsigned int src, unsigned int src_time, unsigned int dst, unsigned int dst_time,
 		unsigned int label, unsigned int src_state, unsigned int dst_state, unordered_map<unsigned long long, unsigned int>& updated_nodes, unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > >& lm_results)
-		// this function performs the backward search from a landmark (lm, state), (src, src_state) and (dst, dst_state) are the src node and dst node of this update, src_time and dst_time are the timestamps of the latest paths from the landmark to these two nodes
-			// updated_nodes record the nodes whose timestamp has been updated in the time info map of the landmark, lm_results record the final-state nodes to which the laste path timestamp has been updated for each updated LM tree, it is used in the following normal tree update.
+	// this function performs the backward search from a landmark (lm, state), (src, src_state) and (dst, dst_state) are the src node and dst node of this update, src_time and dst_time are the timestamps of the latest paths from the landmark to these two nodes
+		// updated_nodes record the nodes whose timestamp has been updated in the time info map of the landmark, lm_results record the final-state nodes to which the laste path timestamp has been updated for each updated LM tree, it is used in the following normal tree update.
+		// When the TI map of an LM tree is updated, the search continues from its root, which is a landmark in other LM trees. The search is depth first like a recursion, but uses an explicit work stack, so long dependency chains do not grow the call stack.
 	{
+		if (back_track_nodes.empty())
+			back_track_nodes.resize(1);
+		back_track_nodes[0].assign(updated_nodes.begin(), updated_nodes.end());
+		back_track_stack.clear();
+		back_track_frame top;
+		top.lm = lm;
+		top.state = state;
+		top.src_time = src_time;
+		top.dst_time = dst_time;
+		top.cur = NULL;
+		top.started = false;
 		map<unsigned int, lm_info_index*>::iterator it = v2l_index.find(state);
-		if (it != v2l_index.end())
+		if (it == v2l_index.end())
+			return;
+		unordered_map<unsigned int, tree_info*>::iterator iter = it->second->tree_index.find(lm); // find the list of LM trees containing this landmark.
+		if (iter == it->second->tree_index.end())
+			return;
+		top.cur = iter->second;
+		back_track_stack.push_back(top);
+		while (!back_track_stack.empty())
 		{
-			unordered_map<unsigned int, tree_info*>::iterator iter = it->second->tree_index.find(lm); // find the list of LM trees containing this landmark.
-			if (iter == it->second->tree_index.end())
-				return;
-			tree_info* cur = iter->second;
-			while (cur)
+			unsigned int level = back_track_stack.size() - 1;
+			back_track_frame& frame = back_track_stack.back();
+			if (frame.started)
+				frame.cur = frame.cur->next;
+			frame.started = true;
+			tree_info* cur = frame.cur;
+			if (!cur)
 			{
-				RPQ_tree* tree_pt = cur->tree;
-				unsigned int root_ID = tree_pt->root->node_ID;
-				unsigned int root_state = tree_pt->root->state;
-				unsigned long long root_info = merge_long_long(root_ID, root_state);
-				if ((root_ID == lm && root_state == state) || lm_results.find(root_info) != lm_results.end()) // skip this tree if it is the tree of the landmark itself, or if we have updated the LM tree.
-				{
-					cur = cur->next;
-					continue;
-				}
-				assert(tree_pt->node_map.find(state) != tree_pt->node_map.end());
-				assert(tree_pt->node_map[state]->index.find(lm) != tree_pt->node_map[state]->index.end());
-
-				tree_node* lm_node = tree_pt->node_map[state]->index[lm];
+				back_track_stack.pop_back();
+				continue;
+			}
+			RPQ_tree* tree_pt = cur->tree;
+			unsigned int root_ID = tree_pt->root->node_ID;
+			unsigned int root_state = tree_pt->root->state;
+			unsigned long long root_info = merge_long_long(root_ID, root_state);
+			if ((root_ID == frame.lm && root_state == frame.state) || lm_results.find(root_info) != lm_results.end()) // skip this tree if it is the tree of the landmark itself, or if we have updated the LM tree.
+				continue;
+			tree_node* lm_node = tree_pt->find_node(frame.lm, frame.state);
+			assert(lm_node != NULL);
 
-				unordered_map<unsigned long long, unsigned int> tracked_nodes;
-				unsigned int local_src_time = min(lm_node->timestamp, src_time); // timestamp of the path from the root of tree_pt to src node passing the landmark.
-				unsigned int local_dst_time = min(lm_node->timestamp, dst_time); // timestamp of the path from the root of tree_pt to dst node passing the landmark.
-				unsigned long long src_info = merge_long_long(src, src_state);
-				unsigned long long dst_info = merge_long_long(dst, dst_state);
-				if (tree_pt->get_time_info(src, src_state) > local_src_time) // if this is not the latest path to the src node, prune this backtrack
-				{
-					cur = cur->next;
+			unsigned int local_src_time = min(lm_node->timestamp, frame.src_time); // timestamp of the path from the root of tree_pt to src node passing the landmark.
+			unsigned int local_dst_time = min(lm_node->timestamp, frame.dst_time); // timestamp of the path from the root of tree_pt to dst node passing the landmark.
+			if (tree_pt->get_time_info(src, src_state) > local_src_time) // if this is not the latest path to the src node, prune this backtrack
+				continue;
+			if (tree_pt->get_time_info(dst, dst_state) >= local_dst_time) // if there is an existing path to dst node with no smaller timestamp, prune this backtrack.
+				continue;
+			if (back_track_nodes.size() <= level + 1)
+				back_track_nodes.resize(level + 2);
+			vector<pair<unsigned long long, unsigned int> >& updated = back_track_nodes[level];
+			vector<pair<unsigned long long, unsigned int> >& tracked_nodes = back_track_nodes[level + 1]; // nodes updated in this tree, used in the next level
+			tracked_nodes.clear();
+			for (unsigned int i = 0; i < updated.size(); i++)
+			{
+				unsigned int time = min(lm_node->timestamp, updated[i].second);
+				if (!tree_pt->raise_time_info((updated[i].first >> 32), (updated[i].first & 0xFFFFFFFF), time)) // if the time info of the node can not be updated, continue to next node
 					continue;
+				tracked_nodes.push_back(make_pair(updated[i].first, time)); // record this node, and use it in further backtrack
+				if (aut->check_final_state(((updated[i].first) & 0xFFFFFFFF))) { // if this is a final state node, record it in lm_result.
+					if (lm_results.find(root_info) == lm_results.end())
+						lm_results[root_info] = vector<pair<unsigned int, unsigned int> >();
+					lm_results[root_info].push_back(make_pair((updated[i].first >> 32), time));
 				}
-				if (tree_pt->get_time_info(dst, dst_state) >= local_dst_time) { // if there is an existing path to dst node with no smaller timestamp, prune this backtrack.
-					cur = cur->next;
+			}
+			if (!tracked_nodes.empty()) {
+				if (root_state == 0) // if this tree has a initial state root, update the result set.
+					update_result(lm_results[root_info], tree_pt->root->node_ID);
+				map<unsigned int, lm_info_index*>::iterator it2 = v2l_index.find(root_state); // continue the search from the root of this tree, in the LM trees containing it.
+				if (it2 == v2l_index.end())
 					continue;
-				}
-				for (unordered_map<unsigned long long, unsigned int>::iterator iter = updated_nodes.begin(); iter != updated_nodes.end(); iter++)
-				{
-					unsigned int time = min(lm_node->timestamp, iter->second);
-					if (tree_pt->get_time_info((iter->first >> 32), (iter->first & 0xFFFFFFFF)) >= time) // if the time info of the node iter->first can not be updated, continue to next node
-						continue;
-					tree_pt->add_time_info((iter->first >> 32), (iter->first & 0xFFFFFFFF), time); // update the time info.
-					tracked_nodes.insert(make_pair(iter->first, time)); // record this node with another vector, and use it in further backtrack
-					if (aut->check_final_state(((iter->first) & 0xFFFFFFFF))) { // if this is a final state node, record it in lm_result.
-						if (lm_results.find(root_info) == lm_results.end())
-							lm_results[root_info] = vector<pair<unsigned int, unsigned int> >();
-						lm_results[root_info].push_back(make_pair((iter->first >> 32), time));
-					}
-				}
-				if (!tracked_nodes.empty()) {
-					if (root_state == 0) // if this tree has a initial state root, update the result set.
-						update_result(lm_results[root_info], tree_pt->root->node_ID);
-					back_track_lm(root_ID, root_state, src, local_src_time, dst, local_dst_time, label, src_state, dst_state, tracked_nodes, lm_results);
-				}
-				tracked_nodes.clear();
-				cur = cur->next;
+				unordered_map<unsigned int, tree_info*>::iterator iter2 = it2->second->tree_index.find(root_ID);
+				if (iter2 == it2->second->tree_index.end())
+					continue;
+				back_track_frame next;
+				next.lm = root_ID;
+				next.state = root_state;
+				next.src_time = local_src_time;
+				next.dst_time = local_dst_time;
+				next.cur = iter2->second;
+				next.started = false;
+				back_track_stack.push_back(next); // frame may be invalid after this push
 			}
 		}
 	}
@@ -318,9 +336,8 @@ public:
 		unsigned long long root_info = merge_long_long(root_ID, root_state);
 		if (lm_results.find(merge_long_long(root_ID, root_state)) != lm_results.end()) return;
 		unordered_map<unsigned long long, unsigned int> updated_nodes;
-		assert(lm_tree->node_map.find(src_state) != lm_tree->node_map.end());
-		assert(lm_tree->node_map[src_state]->index.find(s) != lm_tree->node_map[src_state]->index.end());
-		tree_node* src_pt = lm_tree->node_map[src_state]->index[s];
+		assert(lm_tree->find_node(s, src_state) != NULL);
+		tree_node* src_pt = lm_tree->find_node(s, src_state);
 		unsigned long long src_info = merge_long_long(s, src_state);
 		unsigned long long dst_info = merge_long_long(d, dst_state);
 		if (src_pt->timestamp < lm_tree->get_time_info(s, src_state)) // if the local path is not the latest, prune this update.
@@ -329,10 +346,10 @@ public:
 			return;
 
 		tree_node* dst_pt = NULL;
-		if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.find(d) == lm_tree->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+		if (lm_tree->find_node(d, dst_state) == NULL) // add the dst node if it is not in the tree yet.
 			dst_pt = add_lm_node(lm_tree, d, dst_state, lm_tree->root->node_ID, lm_tree->root->state, src_pt, min(src_pt->timestamp, timestamp), timestamp);
 		else { // else the new timestamp must be larger than the existing timestamp of dst node in this tree, otherwise we should have returned in the above check.
-			dst_pt = lm_tree->node_map[dst_state]->index[d];
+			dst_pt = lm_tree->find_node(d, dst_state);
 			if (dst_pt->timestamp < min(src_pt->timestamp, timestamp))
 			{
 				if (dst_pt->parent != src_pt)
@@ -367,20 +384,16 @@ public:
 		if (forests.find(lm_info) == forests.end())
 			return;
 		RPQ_tree* lm_tree = forests[lm_info];
-		for (unordered_set<int>::iterator fs_iter = aut->final_state.begin(); fs_iter != aut->final_state.end(); fs_iter++) {
-			int final_state = *fs_iter;
-			if (lm_tree->time_info.find(final_state) != lm_tree->time_info.end())
-			{
-				for (unordered_map<unsigned int, unsigned int>::iterator iter = lm_tree->time_info[final_state]->index.begin(); iter != lm_tree->time_info[final_state]->index.end(); iter++)
-				{
-					unsigned int v = iter->first;
-					unsigned int time = min(lm_time, iter->second);
-					if (updated_results.find(v) != updated_results.end())
-						updated_results[v] = max(updated_results[v], time);
-					else
-						updated_results[v] = time;
-				}
-			}
+		for (unsigned int i = 0; i < lm_tree->time_info.capacity; i++) { // scan the time info map for the final state nodes
+			time_info_entry& e = lm_tree->time_info.table[i];
+			if (!e.time || !aut->check_final_state(e.node & 0xFFFFFFFF))
+				continue;
+			unsigned int v = (e.node >> 32);
+			unsigned int time = min(lm_time, e.time);
+			if (updated_results.find(v) != updated_results.end())
+				updated_results[v] = max(updated_results[v], time);
+			else
+				updated_results[v] = time;
 		}
 	}
 
@@ -409,26 +422,24 @@ public:
 				continue;
 			}
 			else {
-				vector<edge_info> vec;
-				g->get_timed_all_suc(tmp->node_ID, vec);  // get all the out edge of the src node
-				for (int i = 0; i < vec.size(); i++)
+				for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next())  // get all the out edge of the src node
 				{
-					unsigned int successor = vec[i].d;
-					unsigned int edge_label = vec[i].label;
+					unsigned int successor = suc->d;
+					unsigned int edge_label = suc->label;
 					int dst_state = aut->get_suc(tmp->state, edge_label); // check if we can travel to a dst state 
 					if (dst_state == -1)
 						continue;
-					unsigned int time = min(tmp->timestamp, vec[i].timestamp); // compute timestamp of the dst node  
-					if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // add dst node to the tree if it does not exist 
-						q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, vec[i].timestamp));
+					unsigned int time = min(tmp->timestamp, suc->timestamp); // compute timestamp of the dst node  
+					if (tree_pt->find_node(successor, dst_state) == NULL) // add dst node to the tree if it does not exist 
+						q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp));
 					else
 					{
-						tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+						tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
 						if (dst_pt->timestamp < time) { // if the timestamp of the new path is larger than the old node time, link dst node to the new path and update its timestamp
 							if (dst_pt->parent != tmp)
 								tree_pt->substitute_parent(tmp, dst_pt);
 							dst_pt->timestamp = time;
-							dst_pt->edge_timestamp = vec[i].timestamp;
+							dst_pt->edge_timestamp = suc->timestamp;
 							q.push(dst_pt);
 						}
 					}
@@ -439,6 +450,34 @@ public:
 		updated_results.clear();
 	}
 
+	vector<lm_handle>& get_lm_handles(RPQ_tree* tree_pt) // return the handles of the landmarks in a normal tree that have LM trees, in the iteration order of its landmark set. The handles are cached in the tree,
+		// and rebuilt only if the landmark set of the tree or the forest has changed since they were built, thus visiting a normal tree does not look up the forest and the node map for each landmark.
+	{
+		lm_handle_cache* cache = tree_pt->lm_cache;
+		if (cache && cache->lm_version == tree_pt->lm_version && cache->forest_epoch == forest_epoch)
+			return cache->handles;
+		if (!cache)
+		{
+			cache = new lm_handle_cache;
+			tree_pt->lm_cache = cache;
+		}
+		cache->handles.clear();
+		for (unordered_set<unsigned long long>::iterator iter = tree_pt->landmarks.begin(); iter != tree_pt->landmarks.end(); iter++)
+		{
+			unordered_map<unsigned long long, RPQ_tree*>::iterator it = forests.find(*iter);
+			if (it == forests.end())
+				continue;
+			lm_handle h;
+			h.lm_info = *iter;
+			h.lm_tree = it->second;
+			h.lm_node = tree_pt->find_node((*iter >> 32), (*iter & 0xFFFFFFFF));
+			cache->handles.push_back(h);
+		}
+		cache->lm_version = tree_pt->lm_version;
+		cache->forest_epoch = forest_epoch;
+		return cache->handles;
+	}
+
 	void visit_non_lm_tree(unsigned int s, unsigned int d, unsigned int label, int timestamp, unsigned int src_state, unsigned int dst_state,
 		RPQ_tree* tree_pt, unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > >& lm_results, unordered_set<unsigned int>& visited)
 	{
@@ -454,55 +493,48 @@ public:
 		unsigned int max_dst_time = 0;
 		unsigned long long max_dst_lm = 0;
 
-		for (unordered_set<unsigned long long>::iterator iter = tree_pt->landmarks.begin(); iter != tree_pt->landmarks.end(); iter++) //we scan the landmarks to check the timestamp of the path to src node and dst node passing them
+		vector<lm_handle>& handles = get_lm_handles(tree_pt);
+		for (unsigned int i = 0; i < handles.size(); i++) //we scan the landmarks to check the timestamp of the path to src node and dst node passing them
 			// and record the largest timestamp, which is the largest timestamp of paths to the src/ dst node passing landmarks.
 		{
-			unsigned long long lm_info = *iter;
-			if (forests.find(lm_info) != forests.end())
-			{
-				RPQ_tree* lm_tree = forests[lm_info];
-				tree_node* lm_node = tree_pt->find_node((lm_info >> 32), (lm_info & 0xFFFFFFFF));
-				unsigned int local_src_time = lm_tree->get_time_info(s, src_state);
-				if (min(local_src_time, lm_node->timestamp) > max_src_time) {
-					max_src_time = min(local_src_time, lm_node->timestamp);
-					max_src_lm = lm_info;
-				}
-				unsigned int local_dst_time = lm_tree->get_time_info(d, dst_state);
-				if (min(local_dst_time, lm_node->timestamp) > max_dst_time) {
-					max_dst_time = min(local_dst_time, lm_node->timestamp);
-					max_dst_lm = lm_info;
-				}
+			unsigned long long lm_info = handles[i].lm_info;
+			tree_node* lm_node = handles[i].lm_node;
+			unsigned int local_src_time = handles[i].lm_tree->get_time_info(s, src_state);
+			if (min(local_src_time, lm_node->timestamp) > max_src_time) {
+				max_src_time = min(local_src_time, lm_node->timestamp);
+				max_src_lm = lm_info;
+			}
+			unsigned int local_dst_time = handles[i].lm_tree->get_time_info(d, dst_state);
+			if (min(local_dst_time, lm_node->timestamp) > max_dst_time) {
+				max_dst_time = min(local_dst_time, lm_node->timestamp);
+				max_dst_lm = lm_info;
 			}
 		}
 
-		if (tree_pt->node_map.find(src_state) != tree_pt->node_map.end()) // if the normal tree contians the src node
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
+		if (src_pt) // if the normal tree contians the src node
 		{
-			tree_node_index* tmp_index = tree_pt->node_map[src_state];
-			if (tmp_index->index.find(s) != tmp_index->index.end())
+			if (!src_pt->lm && src_pt->timestamp > max_src_time && min(src_pt->timestamp, timestamp) > max_dst_time) // we expand this normal tree only if the local path has larger timestamp than the paths passing landmarks
+				// and no exisiting path has larger, or equal timestamp than the new local path to the dst node 
 			{
-				tree_node* src_pt = tmp_index->index[s];
-				if (!src_pt->lm && src_pt->timestamp > max_src_time && min(src_pt->timestamp, timestamp) > max_dst_time) // we expand this normal tree only if the local path has larger timestamp than the paths passing landmarks
-					// and no exisiting path has larger, or equal timestamp than the new local path to the dst node 
+				unsigned int time = min(src_pt->timestamp, timestamp);
+				if (tree_pt->find_node(d, dst_state) == NULL) { // need to be checked
+					tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
+					non_lm_expand(dst_pt, tree_pt);
+				}
+				else
 				{
-					unsigned int time = min(src_pt->timestamp, timestamp);
-					if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) { // need to be checked
-						tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
-						non_lm_expand(dst_pt, tree_pt);
-					}
-					else
+					tree_node* dst_pt = tree_pt->find_node(d, dst_state);
+					if (dst_pt->timestamp < time)
 					{
-						tree_node* dst_pt = tree_pt->node_map[dst_state]->index[d];
-						if (dst_pt->timestamp < time)
-						{
-							if (dst_pt->parent != src_pt)
-								tree_pt->substitute_parent(src_pt, dst_pt);
-							dst_pt->timestamp = time;
-							dst_pt->edge_timestamp = timestamp;
-							non_lm_expand(dst_pt, tree_pt);
-						}
+						if (dst_pt->parent != src_pt)
+							tree_pt->substitute_parent(src_pt, dst_pt);
+						dst_pt->timestamp = time;
+						dst_pt->edge_timestamp = timestamp;
+						non_lm_expand(dst_pt, tree_pt);
 					}
-					return;
 				}
+				return;
 			}
 		}
 
@@ -512,7 +544,7 @@ public:
 		if (lm_results.find(max_src_lm) != lm_results.end()) { // otherwise we find the landmark passing which the timestamp of path to src is latest, and update the result sets with the recorded updated nodes. 
 			unsigned int lm_ID = max_src_lm >> 32;
 			unsigned int lm_state = (max_src_lm & 0xFFFFFFFF);
-			update_result(lm_results[max_src_lm], tree_pt->root->node_ID, tree_pt->node_map[lm_state]->index[lm_ID]->timestamp);
+			update_result(lm_results[max_src_lm], tree_pt->root->node_ID, tree_pt->find_node(lm_ID, lm_state)->timestamp);
 		}
 	}
 
@@ -520,10 +552,12 @@ public:
 	{
 		if (aut->acceptable_labels.find(label) == aut->acceptable_labels.end()) // we only insert the edge if the automaton can accept it, in this case the streaming graph is a layer graph containing necessray edges. 
 			return;
+		s = g->vertex_id(s); // the forests work on internal vertex IDs of the streaming graph.
+		d = g->vertex_id(d);
 		g->insert_edge(s, d, label, timestamp);
 		if (aut->get_suc(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end()) // we need to build a new tree
 		{
-			RPQ_tree* new_tree = new RPQ_tree();
+			RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 			if (landmarks.find(merge_long_long(s, 0)) == landmarks.end()) // a normal tree
 				new_tree->root = add_node(new_tree, s, 0, s, NULL, MAX_INT, MAX_INT);
 			else { // an LM tree
@@ -531,9 +565,9 @@ public:
 				new_tree->add_time_info(s, 0, MAX_INT);
 			}
 			forests[merge_long_long(s, 0)] = new_tree;
+			forest_epoch++;
 		}
-		vector<pair<int, int> >vec;
-		aut->get_possible_state(label, vec); // find all the state paris that can accept this label
+		const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // find all the state paris that can accept this label
 		for (unsigned int i = 0; i < vec.size(); i++) {
 			unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > > lm_results;
 			unsigned int src_state = vec[i].first;
@@ -658,7 +692,7 @@ public:
 				unsigned int v = child->node_ID;
 				unsigned int state = child->state;
 				unsigned int time = min(child->edge_timestamp, expand_tree_node->timestamp); // compute the timestamp of this child in tree_pt
-				if (tree_pt->node_map.find(state) == tree_pt->node_map.end() || tree_pt->node_map[state]->index.find(v) == tree_pt->node_map[state]->index.end())
+				if (tree_pt->find_node(v, state) == NULL)
 				{
 					tree_node* new_node = NULL; // if it does not exist, we add this node
 					if (lm_expand_tree) {
@@ -672,7 +706,7 @@ public:
 				}
 				else
 				{
-					tree_node* new_node = tree_pt->node_map[state]->index[v]; // of the node exists, we update its timestamp.
+					tree_node* new_node = tree_pt->find_node(v, state); // of the node exists, we update its timestamp.
 					if (new_node->timestamp < time)
 					{
 						if (new_node->parent != expand_tree_node)
@@ -696,13 +730,13 @@ public:
 
 	void generate_time_info(RPQ_tree* tree_pt) // this function is used to generate time info map for new LM trees. Time info map is generated as a union of nodes in this LM tree, and the time info map of the landmarks in it.
 	{
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		tree_pt->time_info.reserve(tree_pt->node_cnt); // the nodes of the tree are added at once
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			unsigned int state = iter->first;
-			if (tree_pt->time_info.find(state) == tree_pt->time_info.end())
-				tree_pt->time_info[state] = new time_info_index;
-			for (unordered_map<unsigned int, tree_node*>::iterator node_iter = iter->second->index.begin(); node_iter != iter->second->index.end(); node_iter++)
-				tree_pt->time_info[state]->index[node_iter->first] = node_iter->second->timestamp;
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			tree_pt->add_time_info(node->node_ID, node->state, node->timestamp);
 		}
 		for (unordered_set<unsigned long long>::iterator set_iter = tree_pt->landmarks.begin(); set_iter != tree_pt->landmarks.end(); set_iter++)
 		{
@@ -714,15 +748,7 @@ public:
 			if (forests.find(lm_info) != forests.end())
 			{
 				RPQ_tree* lm_tree = forests[lm_info];
-				for (map<unsigned int, time_info_index*>::iterator iter = lm_tree->time_info.begin(); iter != lm_tree->time_info.end(); iter++)
-				{
-					unsigned int state = iter->first;
-					if (tree_pt->time_info.find(state) == tree_pt->time_info.end())
-						tree_pt->time_info[state] = new time_info_index;
-					for (unordered_map<unsigned int, unsigned int>::iterator info_iter = iter->second->index.begin(); info_iter != iter->second->index.end(); info_iter++)
-						tree_pt->time_info[state]->index[info_iter->first] = max(tree_pt->time_info[state]->index[info_iter->first], min(info_iter->second, lm_time));
-
-				}
+				tree_pt->time_info.merge(lm_tree->time_info, lm_time, NULL);
 			}
 		}
 	}
@@ -730,13 +756,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_index(iter2->first, iter2->second->state, root_ID);
-				add_lm_index(tree_pt, iter2->first, iter2->second->state, root_ID, root_state);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_index(node->node_ID, node->state, root_ID);
+			add_lm_index(tree_pt, node->node_ID, node->state, root_ID, root_state);
 		}
 	}
 
@@ -744,13 +770,13 @@ public:
 	{
 		unsigned int root_ID = tree_pt->root->node_ID;
 		unsigned int root_state = tree_pt->root->state;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-			{
-				delete_lm_index(iter2->first, iter2->second->state, root_ID, root_state);
-				add_index(tree_pt, iter2->first, iter2->second->state, root_ID);
-			}
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			delete_lm_index(node->node_ID, node->state, root_ID, root_state);
+			add_index(tree_pt, node->node_ID, node->state, root_ID);
 		}
 	}
 	void recover_subtree(unsigned int v, unsigned int state, RPQ_tree* lm_tree) // this function recovers the subtrees of a deleted landmark (v, state) in normal trees, lm_tree is the LM tree of this landmark.
@@ -765,8 +791,7 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					tree_pt->landmarks.erase(merge_long_long(v, state));
-					shrink(tree_pt->landmarks);
+					tree_pt->remove_lm(merge_long_long(v, state));
 					tree_node* lm_node = tree_pt->find_node(v, state);
 					lm_node->lm = false;
 					if (lm_tree) {
@@ -807,8 +832,7 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					tree_pt->landmarks.erase(merge_long_long(v, state));
-					shrink(tree_pt->landmarks);
+					tree_pt->remove_lm(merge_long_long(v, state));
 					tree_node* lm_node = tree_pt->find_node(v, state);
 					lm_node->lm = false;
 					if (lm_tree) {
@@ -835,11 +859,13 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					tree_pt->landmarks.insert(merge_long_long(v, state)); // add the new landmark to the landmark set of the normal tree
+					tree_pt->add_lm(merge_long_long(v, state)); // add the new landmark to the landmark set of the normal tree
 					tree_node* lm_node = tree_pt->find_node(v, state);
 					lm_node->lm = true;
 					tree_node* child = lm_node->child;  // carry out a BFS starting from childs of this landmark, and delete all the succesors in its subtree.
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
+					unsigned int node_num = 0;
 					queue<tree_node*> q;
 					while (child)
 					{
@@ -857,20 +883,14 @@ public:
 							q.push(child);
 							child = child->brother;
 						}
-						assert(tree_pt->node_map.find(cur->state) != tree_pt->node_map.end());
-						tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-						shrink(tree_pt->node_map[cur->state]->index);
-						if (tree_pt->node_map[cur->state]->index.empty()) {
-							delete tree_pt->node_map[cur->state];
-							tree_pt->node_map.erase(cur->state);
-						}
+						tree_pt->node_map.erase(cur->node_ID, cur->state);
 						if (cur->lm) {
-							tree_pt->landmarks.erase(merge_long_long(cur->node_ID, cur->state));
-							shrink(tree_pt->landmarks);
+							tree_pt->remove_lm(merge_long_long(cur->node_ID, cur->state));
 						}
-						delete cur;
+						node_num++;
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, node_num);
 					tmp = tmp->next;
 				}
 			}
@@ -895,11 +915,12 @@ public:
 						tmp = tmp->next;
 						continue;
 					}
-					tree_pt->landmarks.insert(merge_long_long(v, state));
+					tree_pt->add_lm(merge_long_long(v, state));
 					tree_node* lm_node = tree_pt->find_node(v, state);
 					lm_node->lm = true;
 					tree_node* child = lm_node->child;
 					lm_node->child = NULL;
+					tree_node* first_child = child; // the children of the landmark and their subtrees are freed together at the end.
 					queue<tree_node*> q;
 					vector<tree_node*> vec;
 					unordered_map<unsigned long long, unsigned int> lm_time; // this map stores timestamps of the path from the landmark (v, state) to each successor in the subtree, if we find a latest path in the subtree but not in lm_tree, we need to add nodes 
@@ -938,19 +959,13 @@ public:
 					for (int i = 0; i < vec.size(); i++)
 					{
 						delete_lm_index(vec[i]->node_ID, vec[i]->state, tree_pt->root->node_ID, tree_pt->root->state);
-						tree_pt->node_map[vec[i]->state]->index.erase(vec[i]->node_ID);
-						shrink(tree_pt->node_map[vec[i]->state]->index);
-						if (tree_pt->node_map[vec[i]->state]->index.empty()) {
-							delete tree_pt->node_map[vec[i]->state];
-							tree_pt->node_map.erase(vec[i]->state);
-						}
+						tree_pt->node_map.erase(vec[i]->node_ID, vec[i]->state);
 						if (vec[i]->lm) {
-							tree_pt->landmarks.erase(merge_long_long(vec[i]->node_ID, vec[i]->state));
-							shrink(tree_pt->landmarks);
+							tree_pt->remove_lm(merge_long_long(vec[i]->node_ID, vec[i]->state));
 						}
-						delete vec[i];
 						tree_pt->node_cnt--;
 					}
+					node_pool.release_siblings(first_child, vec.size());
 					tmp = tmp->next;
 				}
 			}
@@ -964,10 +979,12 @@ public:
 		// the LM tree. Details about how these nodes are missed can be found in the technical report
 	{
 		vector<tree_node*> original_vec;
-		for (map<unsigned int, tree_node_index*>::iterator iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++)
+		for (unsigned int i = 0; i < tree_pt->node_map.capacity; i++)
 		{
-			for (unordered_map<unsigned int, tree_node*>::iterator iter2 = iter->second->index.begin(); iter2 != iter->second->index.end(); iter2++)
-				original_vec.push_back(iter2->second);
+			tree_node* node = tree_pt->node_map.table[i];
+			if (!node)
+				continue;
+			original_vec.push_back(node);
 		}
 
 		for (int i = 0; i < original_vec.size(); i++) // we scan the nodes already in the lm tree one by one, try to expand them to add the necessary nodes.
@@ -979,35 +996,33 @@ public:
 				cur = q.front();
 				q.pop();
 				if (cur->lm) {
-					tree_pt->landmarks.insert(merge_long_long(cur->node_ID, cur->state));
+					tree_pt->add_lm(merge_long_long(cur->node_ID, cur->state));
 					continue;
 				}
-				vector<edge_info> vec;
-				g->get_timed_all_suc(cur->node_ID, vec);
-				for (int j = 0; j < vec.size(); j++)
+				for (suc_iterator suc = g->timed_all_suc(cur->node_ID); suc.valid(); suc.next())
 				{
-					unsigned int successor = vec[j].d;
-					int dst_state = aut->get_suc(cur->state, vec[j].label);
+					unsigned int successor = suc->d;
+					int dst_state = aut->get_suc(cur->state, suc->label);
 					if (dst_state == -1)
 						continue;
-					unsigned int time = min(cur->timestamp, vec[j].timestamp);
+					unsigned int time = min(cur->timestamp, suc->timestamp);
 					if (necessary_nodes.find(merge_long_long(successor, dst_state)) == necessary_nodes.end() && tree_pt->get_time_info(successor, dst_state) > time) // we prune a branch if it is not a necessary nodes and the path to it is not the latest.
 						continue;
-					if (tree_pt->node_map.find(dst_state) != tree_pt->node_map.end() && tree_pt->node_map[dst_state]->index.find(successor) != tree_pt->node_map[dst_state]->index.end())
+					if (tree_pt->find_node(successor, dst_state) != NULL)
 					{
-						tree_node* suc_pt = tree_pt->node_map[dst_state]->index[successor];
+						tree_node* suc_pt = tree_pt->find_node(successor, dst_state);
 						if (suc_pt->timestamp < time)
 						{
 							if (suc_pt->parent != cur)
 								tree_pt->substitute_parent(cur, suc_pt);
-							suc_pt->edge_timestamp = vec[j].timestamp;
+							suc_pt->edge_timestamp = suc->timestamp;
 							suc_pt->timestamp = time;
 							q.push(suc_pt);
 						}
 					}
 					else
 					{
-						tree_node* suc_pt = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, cur, time, vec[j].timestamp, landmarks.find(merge_long_long(successor, dst_state)) != landmarks.end());
+						tree_node* suc_pt = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, cur, time, suc->timestamp, landmarks.find(merge_long_long(successor, dst_state)) != landmarks.end());
 						q.push(suc_pt);
 					}
 				}
@@ -1016,7 +1031,7 @@ public:
 	}
 	RPQ_tree* build_lm_tree(unsigned int v, unsigned int state) // this function build new lm tree for a landmark, we use time info in prune and may miss some nodes, we will add them back with above fulfill_new_lm_tree later .
 	{
-		RPQ_tree* new_tree = new RPQ_tree;
+		RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 		new_tree->root = new_tree->add_node(v, state, NULL, MAX_INT, MAX_INT);
 		new_tree->add_time_info(v, state, MAX_INT);
 		priority_queue<tree_node*, vector<tree_node*>, time_compare> q;
@@ -1029,21 +1044,19 @@ public:
 			{
 				tmp->lm = true;
 				new_tree->add_lm(merge_long_long(tmp->node_ID, tmp->state));
-				unordered_map<unsigned long long, unsigned int> tmp_map;
-				lm_expand_in_lm_subtree(tmp->node_ID, tmp->state, new_tree, tmp->timestamp, tmp_map); // we only need to update the time info map of the new LM tree with the landmark we find
-				tmp_map.clear();
+				unordered_map<unsigned long long, RPQ_tree*>::iterator lm_iter = forests.find(merge_long_long(tmp->node_ID, tmp->state));
+				if (lm_iter != forests.end()) // we only need to update the time info map of the new LM tree with the landmark we find, the updated nodes are not needed
+					new_tree->time_info.merge(lm_iter->second->time_info, tmp->timestamp, NULL);
 				continue;
 			}
 
 			map<int, int> aut_edge;
 			aut->get_all_suc(tmp->state, aut_edge);
-			vector<edge_info>sucs;
-			g->get_timed_all_suc(tmp->node_ID, sucs);
-			for (int i = 0; i < sucs.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next())
 			{
-				unsigned int successor = sucs[i].d;
-				unsigned int label = sucs[i].label;
-				unsigned int time = min(tmp->timestamp, sucs[i].timestamp);
+				unsigned int successor = suc->d;
+				unsigned int label = suc->label;
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
 				if (aut_edge.find(label) == aut_edge.end())
 					continue;
 				int dst_state = aut_edge[label];
@@ -1051,21 +1064,21 @@ public:
 				if (new_tree->get_time_info(successor, dst_state) >= time) // we pruen the branch once there is already a path with no smaller timestamp. this may lead to some nodes missing. they will be added back later in fulfill_new_lm tree. 
 					continue;
 
-				if (new_tree->node_map.find(dst_state) == new_tree->node_map.end() || new_tree->node_map[dst_state]->index.find(successor) == new_tree->node_map[dst_state]->index.end())
+				if (new_tree->find_node(successor, dst_state) == NULL)
 				{
-					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, sucs[i].timestamp);
+					tree_node* new_node = new_tree->add_node(successor, dst_state, tmp, time, suc->timestamp);
 					new_tree->add_time_info(successor, dst_state, time);
 					q.push(new_node);
 				}
 				else
 				{
-					tree_node* dst_pt = new_tree->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = new_tree->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time)
 					{
 						if (dst_pt->parent != tmp)
 							new_tree->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = sucs[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						new_tree->add_time_info(successor, dst_state, time);
 						q.push(dst_pt);
 					}
@@ -1142,15 +1155,15 @@ public:
 				while (tmp)
 				{
 					RPQ_tree* tree_pt = tmp->tree;
-					for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+					for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 					{
-						for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+						tree_node* node = lm_tree->node_map.table[i];
+						if (!node)
+							continue;
+						if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 						{
-							if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-							{
-								node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
-								// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
-							}
+							node_budget--; // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to 
+							// the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
 						}
 					}
 					if (node_budget <= 0)
@@ -1183,14 +1196,14 @@ public:
 					tree_node* lm_node = tree_pt->find_node(v, state);
 					if (tree_pt->get_time_info(v, state) == lm_node->timestamp) // in LM tree we will check if the local path to the landmark is latest, as it costs little.
 					{
-						for (map<unsigned int, tree_node_index*>::iterator node_iter1 = lm_tree->node_map.begin(); node_iter1 != lm_tree->node_map.end(); node_iter1++)
+						for (unsigned int i = 0; i < lm_tree->node_map.capacity; i++)
 						{
-							for (unordered_map<unsigned int, tree_node*>::iterator node_iter2 = node_iter1->second->index.begin(); node_iter2 != node_iter1->second->index.end(); node_iter2++)
+							tree_node* node = lm_tree->node_map.table[i];
+							if (!node)
+								continue;
+							if (tree_pt->find_node(node->node_ID, node->state) == NULL)
 							{
-								if (tree_pt->find_node(node_iter2->first, node_iter1->first) == NULL)
-								{
-									node_budget--;
-								}
+								node_budget--;
 							}
 						}
 					}
@@ -1293,10 +1306,14 @@ public:
 
 	void dynamic_lm_select(double candidate_rate, double benefit_threshold) // the function to select landmarks, first parameter is the candidate selection rate, usually 0.2, the second is the benefit threshold, usually 1.5 
 	{
+		forest_epoch++; // LM trees may be built or deleted
 		vector<unsigned long long> candidates;
-		for (unordered_map<unsigned int, neighbor_list>::iterator iter = g->g.begin(); iter != g->g.end(); iter++)
+		const vector<unsigned int>& vertices = g->vertices_in_window();
+		for (unsigned int i = 0; i < vertices.size(); i++)
 		{
-			unsigned int id = iter->first;
+			unsigned int id = vertices[i];
+			if (g->g[id].lists.empty()) // only vertices with out edges in the window are considered.
+				continue;
 			for (unordered_map<int, automat_edge*>::iterator iter2 = aut->g.begin(); iter2 != aut->g.end(); iter2++)
 			{
 				unsigned int state = iter2->first;
@@ -1378,8 +1395,8 @@ public:
 	}
 	void output_match(ofstream& fout)
 	{
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
-			fout << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << iter->second << endl;
+		for (result_set::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
+			fout << g->external_id(iter->first >> 32) << " " << g->external_id(iter->first & 0xFFFFFFFF) << " " << iter->second << endl; // translate the internal vertex IDs back to the IDs in the stream.
 	}
 	void count(ofstream& fout) // count the memory used in the algorithm, but exclude the memory of automaton and streaming graph, because they are essential for any algorithm.
 	{
@@ -1387,13 +1404,13 @@ public:
 		unsigned int um_size = sizeof(unordered_map<unsigned int, unsigned int>); // size of statistics in a map, which does not change with the key-value type, usually is 56, but may change with the system.
 		unsigned int m_size = sizeof(map<unsigned int, unsigned int>); // size of pointers and statistics in a map, which does not change with the key-value type, usually is 48, but may change with the system.
 
-		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
-		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(um_size + result_pairs.size() * 24 + result_pairs.bucket_count() * 8) / (1024 * 1024)) << endl;
+		cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;   // number of result vertex pairs, and the memory used to store these results.
+		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;
 
 		cout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 		fout << "landmark number " << landmarks.size() << " tree number " << forests.size() << " snapshot graph vertice number " << g->get_vertice_num() << endl;
 
-		unsigned int tree_size = 16 + m_size * 2 + us_size; // size of statistics and pointers in a tree
+		unsigned int tree_size = 16 + sizeof(tree_node_index) + m_size + us_size; // size of statistics and pointers in a tree, including the node map with its inline slots
 		double tree_memory = ((double)(um_size + forests.bucket_count() * 8 + forests.size() * (24 + tree_size)) / (1024 * 1024)); // forest is a unordered_map (um), each KV is 16 byte, 8 byte long long + 8 byte pointer,
 		// plus a pointer pointing to the next KV in the list. Each bucket has a pointer pointing to the head of the value list in this bucket. Memory of following us is computed similarly. size of statistics of each tree is also calculated here.
 		double global_lm_memory = ((double)(us_size + landmarks.size() * 16 + landmarks.bucket_count() * 8) / (1024 * 1024)); // size of the unordered_set (us) landmarks, each value is a 8 byte long long, associated with a pointer pointing to next value in the list.
@@ -1406,18 +1423,15 @@ public:
 		{
 			RPQ_tree* tree_pt = iter->second;
 			lm_set_memory += tree_pt->landmarks.bucket_count() * 8 + tree_pt->landmarks.size() * 16;
-			time_info_memory += tree_pt->time_info.size() * 40; // first layer is a map, and each KV is 24 byte, 3 pointer is associated (parent, left child, right child)
-			for (map<unsigned int, time_info_index*>::iterator iter2 = tree_pt->time_info.begin(); iter2 != tree_pt->time_info.end(); iter2++) {
-				time_info_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * 16; // second layer is a um, and each KV is 8 byte.
-			}
+			if (tree_pt->lm_cache)
+				lm_set_memory += sizeof(lm_handle_cache) + tree_pt->lm_cache->handles.capacity() * sizeof(lm_handle);
+			time_info_memory += tree_pt->time_info.compute_memory(); // the TI map is a table of 12 byte slots, each slot stores a product graph node and its timestamp.
 			unsigned long long info = merge_long_long(tree_pt->root->node_ID, tree_pt->root->state);
 			bool lm_root = false;
 			if (landmarks.find(info) != landmarks.end())
 				lm_root = true; // marks if it is an LM tree
 			double node_memory = 0;
-			node_memory += tree_pt->node_map.size() * 40; // first layer of the node map is a map
-			for (map<unsigned int, tree_node_index*>::iterator iter2 = tree_pt->node_map.begin(); iter2 != tree_pt->node_map.end(); iter2++)
-				node_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * (24 + 48); // second layer is a um, each KV is 16 byte, memory of the tree node is also computed here.
+			node_memory += tree_pt->node_map.compute_memory() + tree_pt->node_map.size * sizeof(tree_node); // the node map is a flat table of pointers, memory of the tree node is also computed here.
 			if (lm_root)
 				lm_node_memory += node_memory;
 			else
@@ -1434,20 +1448,11 @@ public:
 		lm_node_memory += m_size + v2l_index.size() * 40; // firt layer is a map
 		for (map<unsigned int, lm_info_index*>::iterator iter = v2l_index.begin(); iter != v2l_index.end(); iter++)
 		{
-			lm_node_memory += um_size + m_size; // each second layer lm_info_index has a um and a map
+			lm_node_memory += um_size; // each second layer lm_info_index has a um, its info_map and pool are computed below
 			lm_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;  // memory of the um, each KV has 16 bytes.
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					lm_node_num++; // this is the reverse index unit number, as well as the number of nodes in LM trees.
-					tmp = tmp->next;
-				}
-			}
-			lm_node_memory += iter->second->info_map.size() * 48; // each KV of the map has size 24
+			lm_node_num += iter->second->info_map.size; // this is the reverse index unit number, as well as the number of nodes in LM trees.
+			lm_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		lm_node_memory += lm_node_num * 24; // memory of the reverse index units (tree_info)
 		lm_node_memory = (lm_node_memory / (1024 * 1024));
 		cout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
 		fout << "node number in LM tree: " << lm_node_num << ", memory: " << lm_node_memory << endl;
@@ -1457,20 +1462,11 @@ public:
 		tree_node_memory += m_size + v2t_index.size() * 40;
 		for (map<unsigned int, tree_info_index*>::iterator iter = v2t_index.begin(); iter != v2t_index.end(); iter++)
 		{
-			tree_node_memory += um_size + m_size;
+			tree_node_memory += um_size;
 			tree_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					tree_node_num++;
-					tmp = tmp->next;
-				}
-			}
-			tree_node_memory += iter->second->info_map.size() * 40;
+			tree_node_num += iter->second->info_map.size;
+			tree_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		tree_node_memory += tree_node_num * 24;
 		tree_node_memory = (tree_node_memory / (1024 * 1024));
 		cout << "node number in normal tree: " << tree_node_num << ", memory: " << tree_node_memory << endl;
 		cout << "total memory besides result set: " << (tree_memory + global_lm_memory + lm_set_memory + time_info_memory + lm_node_memory + tree_node_memory) << endl;
@@ -1482,23 +1478,14 @@ public:
 
 	void results_update(int time) // this function deletes out dated results with timestamp smaller than given time
 	{
-		if (time <= 0)
-			return;
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end();)
-		{
-			if (iter->second < time) {
-				iter = result_pairs.erase(iter);
-			}
-			else
-				iter++;
-		}
-		shrink(result_pairs);
+		result_pairs.expire(time); // only the calendar buckets older than the threshold are visited.
 	}
 
 	void erase_tree_node(RPQ_tree* tree_pt, tree_node* child)  // this function deletes subtree rooted at the given node (child) in a normal tree (tree_pt)
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1508,8 +1495,9 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 	void erase_lm_tree_node(RPQ_tree* tree_pt, tree_node* child, vector<unsigned long long>& deleted) // this function deletes subtree rooted at the given node (child) in an LM tree (tree_pt), different from above,
@@ -1517,6 +1505,7 @@ public:
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -1527,8 +1516,9 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_lm_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID, tree_pt->root->state);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 
@@ -1556,23 +1546,13 @@ public:
 					for (int i = 0; i < deleted_results.size(); i++)
 					{
 						unsigned long long dst_info = deleted_results[i];
-						unsigned int dst_state = (dst_info & 0xFFFFFFFF);
-						unsigned int dst_ID = (dst_info >> 32);
-						if (tree_pt->time_info.find(dst_state) != tree_pt->time_info.end())
-						{
-							if (tree_pt->time_info[dst_state]->index.find(dst_ID) != tree_pt->time_info[dst_state]->index.end())
-							{
-								if (tree_pt->time_info[dst_state]->index[dst_ID] < expired_time) { // check if the time info entry of a node is expired.
-									tree_pt->time_info[dst_state]->index.erase(dst_ID);
-									shrink(tree_pt->time_info[dst_state]->index);
-								}
-								if (tree_pt->time_info[dst_state]->index.empty())
-									tree_pt->time_info.erase(dst_state);
-							}
-						}
+						time_info_entry* e = tree_pt->time_info.find(dst_info);
+						if (e && e->time < expired_time) // check if the time info entry of a node is expired.
+							tree_pt->time_info.erase(e);
 						tracked_nodes.push_back(dst_info); // it should be noted that we need to futher backtrack up with all nodes in deleted_results, otherwise errors will happen, some expired time info entries will be left
 						// this is caused by circles in the depdency graph.
 					}
+					tree_pt->time_info.shrink();
 					if (!tracked_nodes.empty())
 						expire_backtrack(tree_pt->root->node_ID, tree_pt->root->state, expired_time, tracked_nodes, visited);
 					tracked_nodes.clear();
@@ -1583,71 +1563,52 @@ public:
 	}
 	void expire_per_lm_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // carry out expiration in an LM tree tree_pt given a possibly expired node (v, state) and tail of sliding window expired_time. 
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
-					vector<unsigned long long> erased;
-					vector<unsigned long long> deleted;
-					unordered_set<unsigned long long> visited;
-					erase_lm_tree_node(tree_pt, dst_pt, erased);
-					if (!erased.empty()) {
-						for (unsigned int i = 0; i < erased.size(); i++)
+			if (dst_pt->timestamp < expired_time) { // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
+				vector<unsigned long long> erased;
+				vector<unsigned long long> deleted;
+				unordered_set<unsigned long long> visited;
+				erase_lm_tree_node(tree_pt, dst_pt, erased);
+				if (!erased.empty()) {
+					for (unsigned int i = 0; i < erased.size(); i++)
+					{
+						unsigned long long dst_info = erased[i];
+						if (landmarks.find(dst_info) != landmarks.end()) // if a landmark is deleted, we need to check if it will influence the time info map
 						{
-							unsigned long long dst_info = erased[i];
-							if (landmarks.find(dst_info) != landmarks.end()) // if a landmark is deleted, we need to check if it will influence the time info map
+							if (forests.find(dst_info) != forests.end())
 							{
-								if (forests.find(dst_info) != forests.end())
+								RPQ_tree* dst_tree = forests[dst_info];
+								for (unsigned int j = 0; j < dst_tree->time_info.capacity; j++)
 								{
-									RPQ_tree* dst_tree = forests[dst_info];
-									for (map<unsigned int, time_info_index*>::iterator dst_iter = dst_tree->time_info.begin(); dst_iter != dst_tree->time_info.end(); dst_iter++)
-									{
-										unsigned int state = dst_iter->first;
-										if (tree_pt->time_info.find(state) == tree_pt->time_info.end())
-											continue;
-										time_info_index* target_index = tree_pt->time_info[state];
-										// scan the time info in the LM tree of the deleted landmark, as the paths to nodes in this time info map passing the deleted landmark expire, time info of these nodes 
-										// in tree_pt may also expire, we need to check, and record the expired ones.
-										for (unordered_map<unsigned int, unsigned int>::iterator time_iter = dst_iter->second->index.begin(); time_iter != dst_iter->second->index.end(); time_iter++)
-										{
-											if (target_index->index.find(time_iter->first) != target_index->index.end())
-											{
-												if (target_index->index[time_iter->first] < expired_time) {
-													target_index->index.erase(time_iter->first);
-													deleted.push_back(merge_long_long(time_iter->first, state));
-												}
-											}
-										}
-										shrink(target_index->index);
-										if (target_index->index.empty())
-											tree_pt->time_info.erase(state);
+									time_info_entry& src_entry = dst_tree->time_info.table[j];
+									if (!src_entry.time)
+										continue;
+									// scan the time info in the LM tree of the deleted landmark, as the paths to nodes in this time info map passing the deleted landmark expire, time info of these nodes 
+									// in tree_pt may also expire, we need to check, and record the expired ones.
+									time_info_entry* target = tree_pt->time_info.find(src_entry.node);
+									if (target && target->time < expired_time) {
+										tree_pt->time_info.erase(target);
+										deleted.push_back(src_entry.node);
 									}
 								}
 							}
-							unsigned int dst_ID = (dst_info >> 32);
-							unsigned int dst_state = (dst_info & 0xFFFFFFFF);
-							if (tree_pt->time_info.find(dst_state) != tree_pt->time_info.end()) {  // check time info of this deleted node.
-								if (tree_pt->time_info[dst_state]->index.find(dst_ID) != tree_pt->time_info[dst_state]->index.end())
-								{
-									if (tree_pt->time_info[dst_state]->index[dst_ID] < expired_time) {
-										tree_pt->time_info[dst_state]->index.erase(dst_ID);
-										shrink(tree_pt->time_info[dst_state]->index);
-										if (tree_pt->time_info[dst_state]->index.empty())
-											tree_pt->time_info.erase(dst_state);
-										deleted.push_back(dst_info);
-									}
-								}
-							}
-
 						}
-						erased.clear();
-						visited.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
-						if (!deleted.empty())
-							expire_backtrack(tree_pt->root->node_ID, tree_pt->root->state, expired_time, deleted, visited);
-						deleted.clear();
-						visited.clear();
+						time_info_entry* e = tree_pt->time_info.find(dst_info); // check time info of this deleted node.
+						if (e && e->time < expired_time) {
+							tree_pt->time_info.erase(e);
+							deleted.push_back(dst_info);
+						}
+
 					}
+					tree_pt->time_info.shrink();
+					erased.clear();
+					visited.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
+					if (!deleted.empty())
+						expire_backtrack(tree_pt->root->node_ID, tree_pt->root->state, expired_time, deleted, visited);
+					deleted.clear();
+					visited.clear();
 				}
 			}
 		}
@@ -1655,19 +1616,17 @@ public:
 
 	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // expire in normal tree, we only need to delte the nodes in the subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time)
-					erase_tree_node(tree_pt, dst_pt);
-			}
-
+			if (dst_pt->timestamp < expired_time)
+				erase_tree_node(tree_pt, dst_pt);
 		}
 	}
 
 	void expire(int current_time) //given current time, carry out an expiration in the forest.
 	{
+		forest_epoch++; // trees may be deleted
 		int expire_time = current_time - g->window_size;
 		results_update(expire_time); // delete expired results.
 		vector<edge_info> deleted_edges;
@@ -1677,8 +1636,7 @@ public:
 		{
 			unsigned int dst = deleted_edges[i].d;
 			unsigned int label = deleted_edges[i].label;
-			vector<pair<int, int>> vec;
-			aut->get_possible_state(label, vec); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
+			const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
 			for (int j = 0; j < vec.size(); j++) {
 				int dst_state = vec[j].second;
 				if (dst_state == -1)
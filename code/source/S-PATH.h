@@ -23,13 +23,15 @@ class RPQ_forest
 public:
 	streaming_graph* g; // pointer to the streaming graph .
 	automaton* aut; // pointer to the DFA of the regular expression. 
+	tree_node_pool node_pool; // memory of the tree nodes of this forest, shared by all its trees.
 	unordered_map<unsigned long long, RPQ_tree*> forests; // map from product graph node to tree pointer
 	map<unsigned int, tree_info_index*> v2t_index; // reverse index that maps a graph vertex to the the trees that contains it. The first layer maps state to tree_info_index, and the second layer maps vertex ID to list of trees contains this node
-	unordered_map<unsigned long long, unsigned int> result_pairs; // result set, maps from vertex paris to the largest timestamp of regular paths between them
+	result_set result_pairs; // result set, maps from vertex paris to the largest timestamp of regular paths between them
 
 	RPQ_forest(streaming_graph* g_, automaton* automaton)
 	{
 		g = g_;
+		result_pairs.g = g_;
 		aut = automaton;
 	}
 	~RPQ_forest()
@@ -55,10 +57,7 @@ public:
 			if (dst == root_ID) // self-join is omitted
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time); // if the vertex pair exists, update its timestamp
-			else
-				result_pairs[result_pair] = time; // else add the vertex pair.
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -71,10 +70,7 @@ public:
 			if (dst == root_ID)
 				continue;
 			unsigned long long result_pair = (((unsigned long long)root_ID << 32) | dst);
-			if (result_pairs.find(result_pair) != result_pairs.end())
-				result_pairs[result_pair] = max(result_pairs[result_pair], time);
-			else
-				result_pairs[result_pair] = time;
+			result_pairs.update(result_pair, time); // keep the largest timestamp of the vertex pair.
 		}
 	}
 
@@ -125,26 +121,24 @@ public:
 					updated_results[tmp->node_ID] = tmp->timestamp;
 			}
 
-			vector<edge_info> vec;
-			g->get_timed_all_suc(tmp->node_ID, vec); // get all the successor edges in the snapshot graph, and check each of them to find the successor nodes in the product graph.
-			for (int i = 0; i < vec.size(); i++)
+			for (suc_iterator suc = g->timed_all_suc(tmp->node_ID); suc.valid(); suc.next()) // scan all the successor edges in the snapshot graph in place, and check each of them to find the successor nodes in the product graph.
 			{
-				unsigned int successor = vec[i].d;
-				unsigned int edge_label = vec[i].label;
+				unsigned int successor = suc->d;
+				unsigned int edge_label = suc->label;
 				int dst_state = aut->get_suc(tmp->state, edge_label);
 				if (dst_state == -1)
 					continue;
-				unsigned int time = min(tmp->timestamp, vec[i].timestamp);
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end())// If this node does not exit before, we add this node.
-					q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, vec[i].timestamp));
+				unsigned int time = min(tmp->timestamp, suc->timestamp);
+				if (tree_pt->find_node(successor, dst_state) == NULL)// If this node does not exit before, we add this node.
+					q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, suc->timestamp));
 				else
 				{
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor];
+					tree_node* dst_pt = tree_pt->find_node(successor, dst_state);
 					if (dst_pt->timestamp < time) { // else if its current timestamp is smaller than the new timestamp, we update the timestamp and link it to the new parent.
 						if (dst_pt->parent != tmp)
 							tree_pt->substitute_parent(tmp, dst_pt);
 						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = vec[i].timestamp;
+						dst_pt->edge_timestamp = suc->timestamp;
 						q.push(dst_pt);
 					}
 				}
@@ -157,46 +151,43 @@ public:
 	void insert_per_tree(unsigned int s, unsigned int d, unsigned int label, int timestamp, unsigned int src_state, unsigned int dst_state,
 		RPQ_tree* tree_pt) // processing a new product graph edge from (s, src_state) to (d, dst_state) in a spanning tree tree_pt; 
 	{
-		if (tree_pt->node_map.find(src_state) != tree_pt->node_map.end())
+		tree_node* src_pt = tree_pt->find_node(s, src_state);
+		if (src_pt) // find the src node
 		{
-			tree_node_index* tmp_index = tree_pt->node_map[src_state];
-			if (tmp_index->index.find(s) != tmp_index->index.end()) // find the src node
+			unsigned int time = min(src_pt->timestamp, timestamp);
+			if (tree_pt->find_node(d, dst_state) == NULL) { // if the dst node does not exit
+				tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
+				expand(dst_pt, tree_pt); // add the dst node and futher expand,
+			}
+			else
 			{
-				tree_node* src_pt = tmp_index->index[s];
-				unsigned int time = min(src_pt->timestamp, timestamp);
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) { // if the dst node does not exit
-					tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
-					expand(dst_pt, tree_pt); // add the dst node and futher expand,
-				}
-				else
+				tree_node* dst_pt = tree_pt->find_node(d, dst_state);
+				if (dst_pt->timestamp < time) // if the dst node exit but has a smaller timestamp, update its timestamp, and use expand to propagate the new timestamp down.
 				{
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[d];
-					if (dst_pt->timestamp < time) // if the dst node exit but has a smaller timestamp, update its timestamp, and use expand to propagate the new timestamp down.
-					{
-						if (dst_pt->parent != src_pt)
-							tree_pt->substitute_parent(src_pt, dst_pt);
-						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = timestamp;
-						expand(dst_pt, tree_pt);
-					}
+					if (dst_pt->parent != src_pt)
+						tree_pt->substitute_parent(src_pt, dst_pt);
+					dst_pt->timestamp = time;
+					dst_pt->edge_timestamp = timestamp;
+					expand(dst_pt, tree_pt);
 				}
-					return;
 			}
+				return;
 		}
 	}
 	void insert_edge(unsigned int s, unsigned int d, unsigned int label, int timestamp) //  a new snapshot graph edge (s, d) is inserted, update the spanning forest accordingly.
 	{
 		if (aut->acceptable_labels.find(label) == aut->acceptable_labels.end()) // if the edge is not a part of the regular expression, we do not process this edge;
 			return;
+		s = g->vertex_id(s); // the forest works on internal vertex IDs of the streaming graph.
+		d = g->vertex_id(d);
 		g->insert_edge(s, d, label, timestamp);  // the streaming graph we store, is in fact a layer graph, where only the edges essential to the query. The whole graph can be stored else where, and but considered in our experiment.
 		if (aut->get_suc(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end()) // if this edge can be accepted by the initial state, and this is no spanning tree with root (s, 0), we add this tree
 		{
-			RPQ_tree* new_tree = new RPQ_tree();
+			RPQ_tree* new_tree = new RPQ_tree(&node_pool);
 			new_tree->root = add_node(new_tree, s, 0, s, NULL, MAX_INT, MAX_INT);
 			forests[merge_long_long(s, 0)] = new_tree;
 		}
-		vector<pair<int, int> >vec;
-		aut->get_possible_state(label, vec);// find all the state pairs where the src state can translate to the dst state when accepting this label
+		const vector<pair<int, int> >& vec = aut->get_state_pairs(label);// find all the state pairs where the src state can translate to the dst state when accepting this label
 		for (unsigned int i = 0; i < vec.size(); i++) {
 			unsigned int src_state = vec[i].first;
 			unsigned int dst_state = vec[i].second;
@@ -217,23 +208,14 @@ public:
 	}
 	void results_update(int time) // given the threshold of expiration, delete all the expired result pairs.
 	{
-		if (time <= 0)
-			return;
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end();)
-		{
-			if (iter->second < time) {
-				iter = result_pairs.erase(iter);
-			}
-			else
-				iter++;
-		}
-		shrink(result_pairs);
+		result_pairs.expire(time); // only the calendar buckets older than the threshold are visited.
 	}
 
 	void erase_tree_node(RPQ_tree* tree_pt, tree_node* child) // given an expired node, delete the subtree rooted at it in tree_pt, all the nodes in its subtree also expire. 
 	{
 		queue<tree_node*> q;
 		q.push(child);
+		unsigned int node_num = 0; // number of nodes in the subtree
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent,other nodes donot need to call this function, as there parents and brothers are all deleted;
 		while (!q.empty())
 		{
@@ -243,21 +225,19 @@ public:
 				q.push(cur);
 			tree_pt->remove_node(tmp);
 			delete_index(tmp->node_ID, tmp->state, tree_pt->root->node_ID);
-			delete tmp;
+			node_num++;
 		}
+		node_pool.release_subtree(child, node_num); // the links of the subtree are kept, it is put into the free list as a whole.
 	}
 
 
 	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // given a produce graph node (v, state) which can be possibly an expired node, can try to delete its subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end())
+		tree_node* dst_pt = tree_pt->find_node(v, state);
+		if (dst_pt)
 		{
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				tree_node* dst_pt = tree_pt->node_map[state]->index[v];
-				if (dst_pt->timestamp < expired_time) // if it is indeed an expired node, delete its subtree.
-					erase_tree_node(tree_pt, dst_pt);
-			}
-
+			if (dst_pt->timestamp < expired_time) // if it is indeed an expired node, delete its subtree.
+				erase_tree_node(tree_pt, dst_pt);
 		}
 	}
 
@@ -272,8 +252,7 @@ public:
 		{
 			unsigned int dst = deleted_edges[i].d;
 			unsigned int label = deleted_edges[i].label; // for each expired edge, find its dst node. All the expired nodes in the spanning forest must be in a subtree of such dst node.
-			vector<pair<int, int>> vec;
-			aut->get_possible_state(label, vec); // get possible states of the dst node.
+			const vector<pair<int, int> >& vec = aut->get_state_pairs(label); // get possible states of the dst node.
 			for (int j = 0; j < vec.size(); j++) {
 				int dst_state = vec[j].second;
 				if (dst_state == -1)
@@ -317,8 +296,8 @@ public:
 
 	void output_match(ofstream& fout) // output the recorded result pairs, used to 
 	{
-		for (unordered_map<unsigned long long, unsigned int>::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
-			fout << (iter->first >> 32) << " " << (iter->first & 0xFFFFFFFF) << " " << iter->second << endl;
+		for (result_set::iterator iter = result_pairs.begin(); iter != result_pairs.end(); iter++)
+			fout << g->external_id(iter->first >> 32) << " " << g->external_id(iter->first & 0xFFFFFFFF) << " " << iter->second << endl; // translate the internal vertex IDs back to the IDs in the stream.
 	}
 	void count(ofstream& fout, int expired_time = 0) // count the memory used in the algorithm, but exclude the memory of automaton and streaming graph, because they are essential for any algorithm.
 	{
@@ -327,18 +306,16 @@ public:
 		// the memory of an unordered_map is computed as um_size + bucket_count()*8 + KV_number * (KV_size + 8). It is a hash table where each bucket is a pointer, pointing to a KV list. Each KV is associated with a pointer
 		// pointing to next KV in the list.
 		// the memory of a map is computed as m_size + KV_number * (KV_size + 24). It is a binary search tree where each KV is associated with 3 pointer, 2 for child and 1 for parent.
-		// cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(result_pairs.size() * 24 + result_pairs.bucket_count() * 8 + um_size) / (1024 * 1024)) << endl;  // number of result vertex pairs, and the memory used to store these results.
-		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)(result_pairs.size() * 24 + result_pairs.bucket_count() * 8 + um_size) / (1024 * 1024)) << endl;
-		unsigned int tree_size = m_size + 16; // For S-PATH, we only consider the memory of node_map, root pointer and integer node_num; 
+		// cout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;  // number of result vertex pairs, and the memory used to store these results.
+		fout << "result pair size: " << result_pairs.size() << ", memory: " << ((double)result_pairs.compute_memory() / (1024 * 1024)) << endl;
+		unsigned int tree_size = sizeof(tree_node_index) + 16; // For S-PATH, we only consider the memory of node_map, root pointer and integer node_num; 
 		double tree_memory = ((double)(um_size + forests.bucket_count() * 8 + forests.size() * (24+tree_size)) / (1024 * 1024)); //  forests has KV size 16, 
 		double tree_node_memory = 0;
 		for (unordered_map<unsigned long long, RPQ_tree*>::iterator iter = forests.begin(); iter != forests.end(); iter++)
 		{
 			RPQ_tree* tree_pt = iter->second;
 			double node_memory = 0;
-			node_memory += tree_pt->node_map.size() * 40; 
-			for (map<unsigned int, tree_node_index*>::iterator iter2 = tree_pt->node_map.begin(); iter2 != tree_pt->node_map.end(); iter2++)
-				node_memory += um_size + iter2->second->index.bucket_count() * 8 + iter2->second->index.size() * (24 +40); // 24 is the KV size and 40 is size of each tree node
+			node_memory += tree_pt->node_map.compute_memory() + tree_pt->node_map.size * sizeof(tree_node); // the node map is a flat table of pointers, tree nodes are allocated from a pool without per-node overhead
 			tree_node_memory += node_memory;
 		}
 
@@ -346,20 +323,11 @@ public:
 		tree_node_memory += m_size  + v2t_index.size() * 40; // memory of the first layer of v2t_index, each KV has 16 byte (integer + pointer)
 		for (map<unsigned int, tree_info_index*>::iterator iter = v2t_index.begin(); iter != v2t_index.end(); iter++)
 		{
-			tree_node_memory += um_size + m_size; // each tree_info index has one unordered map and one map
+			tree_node_memory += um_size; // each tree_info index has one unordered map, its info_map and pool are computed below
 			tree_node_memory += iter->second->tree_index.bucket_count() * 8 + iter->second->tree_index.size() * 24;
-			for (unordered_map<unsigned int, tree_info*>::iterator iter2 = iter->second->tree_index.begin(); iter2 != iter->second->tree_index.end(); iter2++)
-			{
-				tree_info* tmp = iter2->second;
-				while (tmp)
-				{
-					tree_node_num++;
-					tmp = tmp->next;
-				}
-			}
-			tree_node_memory += iter->second->info_map.size() * 40; // the KV pair of info_map has size 16
+			tree_node_num += iter->second->info_map.size;
+			tree_node_memory += iter->second->compute_memory(); // memory of the info_map and the pooled tree_info units
 		}
-		tree_node_memory += tree_node_num * 24;
 		tree_node_memory = (tree_node_memory / (1024 * 1024));
 		//cout << "total node number in forest: " << tree_node_num << ", memory: " << tree_node_memory << endl; // the total number of nodes in the forest
 		//cout << "total memory besides result set: " << (tree_memory + tree_node_memory) << endl; // total memory usage
@@ -370,7 +338,7 @@ public:
 
 	}
 
-	void print_tree(unsigned int ID, unsigned int state)
+	void print_tree(unsigned int ID, unsigned int state) // ID is an internal vertex ID, while the printed IDs are the IDs in the stream.
 	{
 
 		unordered_map<unsigned long long, RPQ_tree*>::iterator iter = forests.find(merge_long_long(ID, state));
@@ -385,14 +353,14 @@ public:
 				q.pop();
 				cnt++;
 				if (tmp->lm)
-					cout << "lm node " << tmp->node_ID << ' ' << tmp->state << ' ' << tmp->timestamp << ' ' << tmp->edge_timestamp << endl;
+					cout << "lm node " << g->external_id(tmp->node_ID) << ' ' << tmp->state << ' ' << tmp->timestamp << ' ' << tmp->edge_timestamp << endl;
 				else
-					cout << "node " << tmp->node_ID << ' ' << tmp->state << ' ' << tmp->timestamp << ' ' << tmp->edge_timestamp << endl;
+					cout << "node " << g->external_id(tmp->node_ID) << ' ' << tmp->state << ' ' << tmp->timestamp << ' ' << tmp->edge_timestamp << endl;
 				tmp = tmp->child;
 				cout << "child: " << endl;
 				while (tmp)
 				{
-					cout << tmp->node_ID << " " << tmp->state << endl;
+					cout << g->external_id(tmp->node_ID) << " " << tmp->state << endl;
 					q.push(tmp);
 					tmp = tmp->brother;
 				}
@@ -403,23 +371,19 @@ public:
 		}
 	}
 
-	void print_path(unsigned int ID, unsigned int root_state, unsigned int dst, unsigned int dst_state)
+	void print_path(unsigned int ID, unsigned int root_state, unsigned int dst, unsigned int dst_state) // ID and dst are internal vertex IDs.
 	{
 		unordered_map<unsigned long long, RPQ_tree*>::iterator iter = forests.find(merge_long_long(ID, root_state));
 		if (iter != forests.end()) {
-			if (iter->second->node_map.find(dst_state) != iter->second->node_map.end()) {
-				if (iter->second->node_map[dst_state]->index.find(dst) != iter->second->node_map[dst_state]->index.end()) {
-					tree_node* tmp = iter->second->node_map[dst_state]->index[dst];
-					while (tmp)
-					{
-						cout << tmp->node_ID << ' ' << tmp->state << ' ' << tmp->edge_timestamp << ' ' << tmp->timestamp << ' ';
-						if (tmp->parent)
-							cout << tmp->parent->node_ID << ' ' << tmp->parent->state << endl;
-						else
-							cout << "NULL" << endl;
-						tmp = tmp->parent;
-					}
-				}
+			tree_node* tmp = iter->second->find_node(dst, dst_state);
+			while (tmp)
+			{
+				cout << g->external_id(tmp->node_ID) << ' ' << tmp->state << ' ' << tmp->edge_timestamp << ' ' << tmp->timestamp << ' ';
+				if (tmp->parent)
+					cout << g->external_id(tmp->parent->node_ID) << ' ' << tmp->parent->state << endl;
+				else
+					cout << "NULL" << endl;
+				tmp = tmp->parent;
 			}
 		}
 	}
@@ -6,26 +6,15 @@
 #include<map>
 #include<unordered_map>
 #include<unordered_set>
+#include<algorithm>
 #include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
 using namespace std;
 
 // this streaming graph class suppose that there may be duplicate edges in the streaming graph. It means the same edge (s, d, label) may appear multiple times in the stream.
 
-class sg_edge;
-
-struct timed_edge // this is the structure to maintain the time sequence list. It stores the tuples in the stream with time order, each tuple is an edge; 
-{
-	timed_edge* next;
-	timed_edge* prev; // the two pointers to maintain the list;
-	sg_edge* edge_pt;	// information of the tuple, including src, dst, edge label and timestamp;
-	timed_edge(sg_edge* edge_pt_ = NULL)
-	{
-		edge_pt = edge_pt_;
-		next = NULL;
-		prev = NULL;
-	}
-};
-
 struct edge_info // the structure as query result, include all the information of an edge;
 {
 	unsigned int s, d;
@@ -46,7 +35,6 @@ public:
 	unsigned int s, d;
 	int label;
 	unsigned int timestamp;
-	timed_edge* time_pos;
 	sg_edge* src_prev;
 	sg_edge* src_next;	// cross list, maintaining the graph structure
 	sg_edge* dst_next;
@@ -61,152 +49,624 @@ public:
 		src_prev = NULL;
 		dst_next = NULL;
 		dst_prev = NULL;
-		time_pos = NULL;
 	}
 	~sg_edge()
 	{}
 };
 
-struct neighbor_list  // this struct serves as the head pointed of the neighbor list of a vertex
+#define edge_index_min_capacity 16
+#define slab_bytes 65536 // size of a slab in the edge pools, must be a power of 2, as slabs are aligned to their size to find the slab of an object from its address.
+
+template <class T>
+class slab_pool // pool of objects that are allocated in time order and released roughly in time order, used for sg_edge. Objects are bump allocated in the newest slab, and each slab counts its live objects.
+	// when all the objects in a slab are released, the whole slab is returned, thus the expiration of a window slide frees memory in slab granularity.
+	// objects are kept in time order, thus the pool is also a time log of the objects: front() returns the oldest object that is not released yet. T should be trivially destructible, as the objects left in the pool are not destroyed in the destructor.
+	// slots released out of time order (like the old copies of refreshed edges) are reclaimed by compact, which moves the live objects of a sparse slab together, keeping their order.
 {
-	sg_edge* list_head;
-	neighbor_list(sg_edge* head = NULL)
+	static const unsigned int bitmap_words = slab_bytes / sizeof(T) / 64 + 1;
+	struct slab
 	{
-		list_head = head;
+		slab* prev;
+		slab* next; // slabs are linked in allocation order.
+		unsigned int used; // number of slots that have been allocated in this slab.
+		unsigned int live; // number of slots that are allocated and not released yet.
+		unsigned int first; // slots before it are all released, used to find the oldest object.
+		unsigned long long released[bitmap_words]; // bitmap of released slots.
+	};
+public:
+	static const unsigned int header_bytes = (sizeof(slab) + 63) / 64 * 64; // slots start at a cache line boundary.
+	static const unsigned int slots_per_slab = (slab_bytes - header_bytes) / sizeof(T);
+	slab* head; // oldest slab
+	slab* tail; // newest slab, where new objects are allocated.
+	slab* spare; // an empty slab kept for reuse, so that a window slide followed by insertions does not return and request memory repeatedly.
+	unsigned int slab_num; // number of slabs in the list.
+	slab_pool()
+	{
+		head = NULL;
+		tail = NULL;
+		spare = NULL;
+		slab_num = 0;
+	}
+	~slab_pool()
+	{
+		while (head)
+		{
+			slab* cur = head;
+			head = head->next;
+			free(cur);
+		}
+		if (spare)
+			free(spare);
+	}
+	static slab* owner(T* p) // the slab containing an object.
+	{
+		return (slab*)((uintptr_t)p & ~(uintptr_t)(slab_bytes - 1));
+	}
+	static T* slot(slab* cur, unsigned int i)
+	{
+		return (T*)((char*)cur + header_bytes) + i;
+	}
+	T* allocate() // return the memory of a new object, which should be constructed with placement new. The new object is always the latest one in the time log.
+	{
+		if (!tail || tail->used == slots_per_slab)
+			add_slab();
+		T* p = slot(tail, tail->used);
+		tail->used++;
+		tail->live++;
+		return p;
+	}
+	bool release(T* p) // destroy an object and release its slot. A slab is returned when all its objects are released, unless new objects are still allocated in it. Return false if the slab of p is returned.
+	{
+		p->~T();
+		slab* cur = owner(p);
+		unsigned int i = p - slot(cur, 0);
+		cur->released[i >> 6] |= (1ULL << (i & 63));
+		cur->live--;
+		if (cur->live == 0 && (cur != tail || cur->used == slots_per_slab))
+		{
+			remove_slab(cur);
+			return false;
+		}
+		return true;
+	}
+	template <class R>
+	void compact(T* p, R* mover) // called after p is released, reclaims the released slots of its slab if at least half of the used slots and 3/4 of the slab are released. The live objects are appended to the previous slab if they fit in it,
+		// and the slab is returned, otherwise they are moved to the front of the slab. mover->relocate(from, to) copies an object to a new slot and redirects the pointers to it. The newest slab is not compacted, as objects are still allocated in it.
+	{
+		slab* cur = owner(p);
+		if (cur == tail || cur->live * 2 > cur->used || cur->live * 4 > slots_per_slab)
+			return;
+		slab* prev = cur->prev;
+		if (prev && prev->live + cur->live <= slots_per_slab && (prev->live == prev->used || prev->live <= cur->used - cur->live)) // the objects of prev are older than those of cur, thus the time order is kept. prev is compacted first if it has released slots,
+			// which moves no more objects than the slots released in cur, so that the moves of a compaction are paid by the releases before it.
+		{
+			unsigned int pos = prev->live == prev->used ? prev->used : move_live(prev, prev, 0, mover);
+			pos = move_live(cur, prev, pos, mover);
+			reset(prev, pos);
+			remove_slab(cur);
+			return;
+		}
+		reset(cur, move_live(cur, cur, 0, mover));
+	}
+	template <class R>
+	unsigned int move_live(slab* src, slab* dst, unsigned int pos, R* mover) // move the live objects of src in order to the slots of dst from pos, return the slot after the last moved object. dst is either src or an older slab.
+	{
+		for (unsigned int i = src->first; i < src->used; i++)
+		{
+			if (src->released[i >> 6] >> (i & 63) & 1)
+				continue;
+			T* from = slot(src, i);
+			T* to = slot(dst, pos++);
+			if (from != to)
+				mover->relocate(from, to);
+		}
+		return pos;
+	}
+	void reset(slab* cur, unsigned int live) // after compaction the first live slots of the slab are occupied, and there is no released slot.
+	{
+		cur->used = cur->live = live;
+		cur->first = 0;
+		for (unsigned int i = 0; i < bitmap_words; i++)
+			cur->released[i] = 0;
+	}
+	T* front() // the oldest object which is not released, NULL if the pool is empty.
+	{
+		if (!head)
+			return NULL;
+		while (head->first < head->used && (head->released[head->first >> 6] >> (head->first & 63) & 1)) // skip the released slots, a slab with no live object is already returned unless it is the newest, thus the scan stops in the head slab.
+			head->first++;
+		if (head->first < head->used)
+			return slot(head, head->first);
+		return NULL;
+	}
+	void add_slab()
+	{
+		slab* cur = spare;
+		spare = NULL;
+		if (!cur)
+		{
+			void* mem = NULL;
+			if (posix_memalign(&mem, slab_bytes, slab_bytes) != 0)
+				throw bad_alloc();
+			cur = (slab*)mem;
+		}
+		cur->used = 0;
+		cur->live = 0;
+		cur->first = 0;
+		for (unsigned int i = 0; i < bitmap_words; i++)
+			cur->released[i] = 0;
+		cur->next = NULL;
+		cur->prev = tail;
+		if (tail)
+			tail->next = cur;
+		else
+			head = cur;
+		tail = cur;
+		slab_num++;
+	}
+	void remove_slab(slab* cur)
+	{
+		if (cur->prev)
+			cur->prev->next = cur->next;
+		else
+			head = cur->next;
+		if (cur->next)
+			cur->next->prev = cur->prev;
+		else
+			tail = cur->prev;
+		slab_num--;
+		if (!spare)
+			spare = cur;
+		else
+			free(cur);
+	}
+	unsigned int compute_memory() // memory of all the slabs, including the spare one.
+	{
+		return sizeof(slab_pool) + (slab_num + (spare ? 1 : 0)) * slab_bytes;
 	}
 };
 
-
-class streaming_graph
+class edge_index // open addressing hash table that maps (src, dst, label) of an edge to its sg_edge, used to find duplicate edges without scanning the successor list of the source vertex.
+	// linear probing is used, and deletion is carried out with backward shift, thus no tombstone is left in the table.
 {
 public:
-	unordered_map<unsigned int, neighbor_list> g; // successor list
-	unordered_map<unsigned int, neighbor_list> rg; // precursor list
-	int window_size;  // length of the window, defined in time units.
-	int window_slide; // the slide of the window, defined in time units.
-	int edge_num; // number of edges in the window
-	timed_edge* time_list_head; // head of the time sequence list;
-	timed_edge* time_list_tail;// tial of the time sequence list
-
-	streaming_graph(int w) {
-		edge_num = 0;
-		window_size = w;
-		time_list_head = NULL;
-		time_list_tail = NULL;
+	sg_edge** table; // slots of the table, NULL means an empty slot.
+	unsigned int capacity; // number of slots, always a power of 2.
+	unsigned int size; // number of edges in the table.
+	edge_index()
+	{
+		capacity = edge_index_min_capacity;
+		size = 0;
+		table = new sg_edge * [capacity];
+		for (unsigned int i = 0; i < capacity; i++)
+			table[i] = NULL;
 	}
-	~streaming_graph()
+	~edge_index()
+	{
+		delete[] table;
+	}
+	static unsigned long long hash(unsigned int s, unsigned int d, int label) // mix the three fields of an edge into a 64-bit hash value.
+	{
+		unsigned long long h = (((unsigned long long)s << 32) | d) ^ ((unsigned long long)(unsigned int)label * 0x9E3779B97F4A7C15ULL);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+	sg_edge* find(unsigned int s, unsigned int d, int label) // return the edge (s, d, label), or NULL if it does not exist.
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it;
-		for (it = g.begin(); it != g.end(); it++) // delete the edges
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(s, d, label) & mask;
+		while (table[pos])
 		{
-			sg_edge* tmp = it->second.list_head;
-			sg_edge* parent = tmp;
-			while (tmp)
+			sg_edge* cur = table[pos];
+			if (cur->s == s && cur->d == d && cur->label == label)
+				return cur;
+			pos = (pos + 1) & mask;
+		}
+		return NULL;
+	}
+	void insert(sg_edge* e) // insert a new edge, the caller guarantees that (s, d, label) of this edge is not in the table yet.
+	{
+		if ((size + 1) * 2 > capacity) // keep the load factor under 0.5, so that the probe sequences stay short.
+			rehash(capacity * 2);
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(e->s, e->d, e->label) & mask;
+		while (table[pos])
+			pos = (pos + 1) & mask;
+		table[pos] = e;
+		size++;
+	}
+	void replace(sg_edge* old_e, sg_edge* e) // replace the pointer of an edge with its new copy, which has the same (s, d, label).
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(e->s, e->d, e->label) & mask;
+		while (table[pos] && table[pos] != old_e)
+			pos = (pos + 1) & mask;
+		if (table[pos])
+			table[pos] = e;
+	}
+	void erase(sg_edge* e) // delete an edge from the table.
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(e->s, e->d, e->label) & mask;
+		while (table[pos] && table[pos] != e)
+			pos = (pos + 1) & mask;
+		if (!table[pos])
+			return;
+		table[pos] = NULL;
+		size--;
+		unsigned int next = (pos + 1) & mask;
+		while (table[next]) // backward shift, move the following edges in the cluster forward if their home slot is not in (pos, next]
+		{
+			unsigned int home = hash(table[next]->s, table[next]->d, table[next]->label) & mask;
+			if (((next - home) & mask) >= ((next - pos) & mask))
 			{
-				parent = tmp;
-				tmp = tmp->src_next;
-				delete parent;
+				table[pos] = table[next];
+				table[next] = NULL;
+				pos = next;
 			}
+			next = (next + 1) & mask;
 		}
-		g.clear();
-		rg.clear(); // each edge only has one copy, liked by cross lists. Thus we only need to scan the successor lists to delete all edges;
-		timed_edge* tmp = time_list_head; // delete the time sequence list;
-		while (tmp)
+		if (capacity > edge_index_min_capacity && size * 8 < capacity) // shrink the table if it becomes too sparse after massive expiration.
+			rehash(capacity / 2);
+	}
+	void rehash(unsigned int new_capacity) // move all the edges to a new table with the given capacity.
+	{
+		sg_edge** old_table = table;
+		unsigned int old_capacity = capacity;
+		capacity = new_capacity;
+		table = new sg_edge * [capacity];
+		for (unsigned int i = 0; i < capacity; i++)
+			table[i] = NULL;
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = 0; i < old_capacity; i++)
 		{
-			timed_edge* cur = tmp;
-			tmp = tmp->next;
-			delete cur;
+			if (!old_table[i])
+				continue;
+			unsigned int pos = hash(old_table[i]->s, old_table[i]->d, old_table[i]->label) & mask;
+			while (table[pos])
+				pos = (pos + 1) & mask;
+			table[pos] = old_table[i];
 		}
+		delete[] old_table;
 	}
-	void add_timed_edge(timed_edge* cur) // add an edge to the time sequence list. As edges arrive in time order, it will be added to the tail.
+	unsigned int compute_memory() // memory of the table, each slot is a 8 byte pointer.
 	{
-		cur->next = NULL;
-		cur->prev = time_list_tail;
-		if (!time_list_head) // if the list is empty, then this is the head.
-			time_list_head = cur;
-		if (time_list_tail)
-			time_list_tail->next = cur;
-		time_list_tail = cur; // cur is the new tail
-	}
-	void delete_timed_edge(timed_edge* cur) // delete an edge from the time list;
-	{
-		if (time_list_head == cur)
-			time_list_head = cur->next;
-		if (time_list_tail == cur)
-			time_list_tail = cur->prev;
-		if (cur->prev)
-			(cur->prev)->next = cur->next; // disconnet it with its precursor and successor
-		if (cur->next)
-			(cur->next)->prev = cur->prev;
+		return sizeof(edge_index) + capacity * 8;
 	}
+};
 
-	bool insert_edge(int s, int d, int label, int timestamp) // insert an edge in the streaming graph, bool indicates if it is a new edge (not appear before)
+struct label_list // head of the edges with the same label in a neighbor list, together with the number of such edges
+{
+	int label;
+	unsigned int degree;
+	sg_edge* list_head;
+	label_list(int label_, sg_edge* head = NULL)
+	{
+		label = label_;
+		list_head = head;
+		degree = (head ? 1 : 0);
+	}
+};
+
+struct neighbor_list  // this struct serves as the head pointed of the neighbor list of a vertex. Edges are partitioned by their labels, and each label has its own list, so that
+	// queries restricted to a label only touch the edges with this label. The number of labels of a vertex is small, as the streaming graph only contains labels in the query, thus we use a vector.
+{
+	vector<label_list> lists;
+	neighbor_list() {}
+	neighbor_list(sg_edge* head, int label)
 	{
-		timed_edge* cur = new timed_edge; // create a new timed edge and insert it to the tail of the time sequence list, as in a streaming graph the inserted edge is always the latest 
-		add_timed_edge(cur);
+		lists.push_back(label_list(label, head));
+	}
+	label_list* find(int label) // find the list of the given label, return NULL if there is no edge with this label.
+	{
+		for (unsigned int i = 0; i < lists.size(); i++)
+		{
+			if (lists[i].label == label)
+				return &lists[i];
+		}
+		return NULL;
+	}
+	void erase(int label) // delete the list of a label when it becomes empty.
+	{
+		for (unsigned int i = 0; i < lists.size(); i++)
+		{
+			if (lists[i].label == label)
+			{
+				lists[i] = lists.back();
+				lists.pop_back();
+				return;
+			}
+		}
+	}
+};
 
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
 
-		if (it != g.end())
+class csr_snapshot // a frozen copy of the successor lists in compressed sparse row format, built at each window slide. Traversals read the successors of a vertex from contiguous arrays instead of the cross lists.
+	// like the cross lists, the out edges of a vertex are partitioned by label: each (vertex, label) pair is a group with a contiguous range of edges, so that a query restricted to a label only reads the edges with this label.
+	// vertices which get new or refreshed out edges after the snapshot is built are marked as dirty, they form the delta of the snapshot, and their successors are read from the cross lists.
+{
+public:
+	vector<unsigned int> offsets; // the label groups of vertex v are [offsets[v], offsets[v + 1]) of the group arrays.
+	vector<int> group_label; // label of each group
+	vector<unsigned int> group_start; // edges of group k are stored in [group_start[k], group_start[k + 1]) of the edge arrays, the last entry is the edge number.
+	vector<unsigned int> dst;
+	vector<unsigned int> timestamp;
+	vector<bool> dirty; // whether a vertex has changed since the snapshot is built.
+	vector<unsigned int> dirty_list; // the changed vertices.
+	bool valid; // whether the snapshot has been built.
+	csr_snapshot()
+	{
+		valid = false;
+	}
+	bool contains(unsigned int v) // whether the successors of v can be read from the snapshot.
+	{
+		return valid && v + 1 < offsets.size() && !dirty[v];
+	}
+	bool find(unsigned int v, int label, unsigned int& begin, unsigned int& end) const // find the edge range of v with the given label, return false if there is no such edge.
+	{
+		for (unsigned int k = offsets[v]; k < offsets[v + 1]; k++)
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			if (group_label[k] == label)
 			{
-				if (tmp->label == label && tmp->d == d) // If we find the edge in the cross list, this is not a new edge, and we only update its timestamp and pointer to the time sequence list;
-				{
-				    delete_timed_edge(tmp->time_pos);
-				    tmp->time_pos = cur; 
-				    cur->edge_pt = tmp;
-					tmp->timestamp = timestamp;
-					return false;
-				}
-				tmp = tmp->src_next;
+				begin = group_start[k];
+				end = group_start[k + 1];
+				return true;
 			}
-			edge_num++; // if not appears before
-			tmp = new sg_edge(s, d, label, timestamp); // create a new sg_edge
-			tmp->time_pos = cur;
-			cur->edge_pt = tmp;
-			tmp->src_next = it->second.list_head; // add it to the front of the successor list of the src node 
-			if(it->second.list_head)
-				it->second.list_head->src_prev = tmp;
-			it->second.list_head = tmp;
-			unordered_map<unsigned int, neighbor_list>::iterator it2 = rg.find(d);
-			if (it2 != rg.end())
+		}
+		return false;
+	}
+	void mark(unsigned int v) // mark the vertex as changed.
+	{
+		if (valid && v < dirty.size() && !dirty[v])
+		{
+			dirty[v] = true;
+			dirty_list.push_back(v);
+		}
+	}
+	unsigned int compute_memory()
+	{
+		return sizeof(csr_snapshot) + offsets.capacity() * 4 + group_label.capacity() * 8 + dst.capacity() * 8 + dirty.capacity() / 8 + dirty_list.capacity() * 4; // each group has a label and a start, each edge has dst and timestamp, 8 byte in total.
+	}
+};
+
+class suc_iterator // iterates the out edges of a vertex in place, without copying them into a vector. The edges are read from the CSR snapshot if the vertex is in it, otherwise from the cross lists.
+	// the current edge is accessed with -> or *, and the graph should not be modified during the iteration.
+{
+public:
+	edge_info cur; // the current edge.
+	const csr_snapshot* snap; // the snapshot, NULL if the edges are read from the cross lists.
+	unsigned int pos, end; // position of the current edge and the end of the range in the snapshot.
+	unsigned int group, group_end; // the current label group and the end of the groups of the vertex in the snapshot.
+	neighbor_list* list; // the neighbor list of the vertex, NULL if the vertex has no out edge.
+	unsigned int list_id; // the current label list.
+	sg_edge* e; // the current edge in the cross list.
+	suc_iterator(unsigned int s, const csr_snapshot* snap_, neighbor_list* list_) : cur(s, 0, 0, 0)
+	{
+		snap = snap_;
+		list = list_;
+		e = NULL;
+		list_id = 0;
+		pos = end = 0;
+		group = group_end = 0;
+		if (snap)
+		{
+			group = snap->offsets[s];
+			group_end = snap->offsets[s + 1];
+			if (group < group_end)
 			{
-				tmp->dst_next = it2->second.list_head;  // add it to the front of the precursor list of the dst node
-				if(it2->second.list_head)
-					it2->second.list_head->dst_prev = tmp;
-				it2->second.list_head = tmp;
+				pos = snap->group_start[group];
+				end = snap->group_start[group_end];
 			}
-			else {
-				rg[d] = neighbor_list(tmp);
+		}
+		else if (list)
+		{
+			while (!e && list_id < list->lists.size()) // find the first non-empty list.
+			{
+				e = list->lists[list_id].list_head;
+				if (!e)
+					list_id++;
 			}
-			return true;
 		}
-		else // else the source vertex does not show up in the graph, we need to add a neighbor list, and add the new edge to the neighbor list.
+		load();
+	}
+	bool valid()
+	{
+		return snap ? pos < end : e != NULL;
+	}
+	void next()
+	{
+		if (snap)
 		{
-			edge_num++;
-			sg_edge* tmp = new sg_edge(s, d, label,timestamp);
-			tmp->time_pos = cur;
-			cur->edge_pt = tmp;
-			g[s] = neighbor_list(tmp);
-			unordered_map<unsigned int, neighbor_list>::iterator it2 = rg.find(d);
-			if (it2 != rg.end())
+			pos++;
+			while (group < group_end && pos >= snap->group_start[group + 1]) // move to the next label group, groups are never empty.
+				group++;
+		}
+		else
+		{
+			e = e->src_next;
+			while (!e && ++list_id < list->lists.size()) // move to the next label list.
+				e = list->lists[list_id].list_head;
+		}
+		load();
+	}
+	void load() // copy the fields of the current edge to cur.
+	{
+		if (snap)
+		{
+			if (pos < end)
 			{
-				tmp->dst_next = it2->second.list_head;
-				if(it2->second.list_head)
-					it2->second.list_head->dst_prev = tmp;
-				it2->second.list_head = tmp;
+				cur.d = snap->dst[pos];
+				cur.label = snap->group_label[group];
+				cur.timestamp = snap->timestamp[pos];
 			}
-			else
-				rg[d] = neighbor_list(tmp);
-			return true;
 		}
+		else if (e)
+		{
+			cur.d = e->d;
+			cur.label = e->label;
+			cur.timestamp = e->timestamp;
+		}
+	}
+	const edge_info* operator->() const
+	{
+		return &cur;
+	}
+	const edge_info& operator*() const
+	{
+		return cur;
+	}
+};
+
+class vertex_dictionary // maps the vertex IDs in the stream (external IDs) to dense internal IDs, so that per-vertex structures can be stored in vectors indexed by the internal ID, instead of hash maps.
+	// internal IDs are never reused: the query engines keep the IDs of vertices which have left the window in their results, thus the dictionary grows with the distinct vertices of the stream.
+{
+public:
+	unordered_map<unsigned int, unsigned int> ids; // external ID -> internal ID
+	vector<unsigned int> external; // internal ID -> external ID
+	unsigned int find(unsigned int ext) // return the internal ID of a vertex, or -1 if it is not in the dictionary.
+	{
+		unordered_map<unsigned int, unsigned int>::iterator it = ids.find(ext);
+		if (it != ids.end())
+			return it->second;
+		return -1;
+	}
+	unsigned int get_id(unsigned int ext) // return the internal ID of a vertex, a new ID is assigned if the vertex is not in the dictionary.
+	{
+		unordered_map<unsigned int, unsigned int>::iterator it = ids.find(ext);
+		if (it != ids.end())
+			return it->second;
+		unsigned int id = external.size();
+		external.push_back(ext);
+		ids[ext] = id;
+		return id;
+	}
+	unsigned int compute_memory()
+	{
+		return sizeof(vertex_dictionary) + ids.size() * 16 + ids.bucket_count() * 8 + external.capacity() * 4; // each KV in the hash map has 8 byte plus a pointer of 8 byte, each ID has a 4 byte entry in the vector.
+	}
+};
+
+class streaming_graph
+{
+public:
+	vector<neighbor_list> g; // successor list, indexed by the internal vertex ID
+	vector<neighbor_list> rg; // precursor list
+	vertex_dictionary dict; // maps vertex IDs in the stream to the internal IDs. The streaming graph and the query engines work on internal IDs, and translate them back when the results are reported.
+	int window_size;  // length of the window, defined in time units.
+	int window_slide; // the slide of the window, defined in time units.
+	int edge_num; // number of edges in the window
+	edge_index index; // hash index from (src, dst, label) to the edge, used to find duplicate edges.
+	slab_pool<sg_edge> edge_pool; // memory pool of the edges. Edges are stored in the pool in time order, and the pool also serves as the time sequence list.
+	vector<unsigned int> window_vertices; // internal IDs of the vertices with edges in the window, sorted by vertices_in_window when it is read.
+	vector<unsigned int> window_pos; // position of each vertex in window_vertices, -1 if the vertex has no edge in the window.
+	bool window_sorted; // whether window_vertices is sorted.
+	bool use_snapshot; // whether a CSR snapshot of the successor lists is built at each window slide, it speeds up traversals in the expansion and recovery of spanning trees, at the cost of rebuilding it in each slide.
+	csr_snapshot snapshot;
+
+	streaming_graph(int w, bool use_snapshot_ = false) {
+		edge_num = 0;
+		window_size = w;
+		window_sorted = true;
+		use_snapshot = use_snapshot_;
+	}
+	~streaming_graph()
+	{
+		g.clear();
+		rg.clear(); // the edges are freed together with the memory pool.
+	}
+	unsigned int vertex_id(unsigned int v) // translate a vertex ID in the stream to the internal ID, called by the query engines before an edge is inserted.
+	{
+		unsigned int id = dict.get_id(v);
+		if (id >= g.size())
+		{
+			g.resize(id + 1);
+			rg.resize(id + 1);
+			window_pos.resize(id + 1, -1);
+		}
+		return id;
+	}
+	unsigned int external_id(unsigned int id) // translate an internal vertex ID back to the ID in the stream.
+	{
+		return dict.external[id];
+	}
+
+	bool insert_edge(int s, int d, int label, int timestamp) // insert an edge in the streaming graph, s and d are internal IDs, bool indicates if it is a new edge (not appear before)
+	{
+		snapshot.mark(s); // the out edges of s in the snapshot are out of date.
+		sg_edge* tmp = index.find(s, d, label);
+		if (tmp) // If we find the edge in the edge index, this is not a new edge, and we only update its timestamp and position in the time sequence list;
+		{
+			tmp = move_edge(tmp); // move the edge to the tail of the edge pool, which keeps the pool in time order.
+			tmp->timestamp = timestamp;
+			return false;
+		}
+
+		edge_num++; // if not appears before
+		enter_window(s);
+		enter_window(d);
+		tmp = new (edge_pool.allocate()) sg_edge(s, d, label, timestamp); // create a new sg_edge at the tail of the edge pool, as in a streaming graph the inserted edge is always the latest 
+		index.insert(tmp);
+		label_list* list = g[s].find(label);
+		if (list)
+		{
+			tmp->src_next = list->list_head; // add it to the front of the successor list of the src node with the given label
+			list->list_head->src_prev = tmp;
+			list->list_head = tmp;
+			list->degree++;
+		}
+		else // else the source vertex has no edge with this label, we need to add a list for this label.
+			g[s].lists.push_back(label_list(label, tmp));
+		list = rg[d].find(label);
+		if (list)
+		{
+			tmp->dst_next = list->list_head;  // add it to the front of the precursor list of the dst node with the given label
+			list->list_head->dst_prev = tmp;
+			list->list_head = tmp;
+			list->degree++;
+		}
+		else
+			rg[d].lists.push_back(label_list(label, tmp));
+		return true;
+	}
+
+	sg_edge* move_edge(sg_edge* e) // copy an edge to a new slot at the tail of the edge pool, and redirect the cross lists and the edge index to the copy.
+	{
+		sg_edge* moved = edge_pool.allocate();
+		relocate(e, moved);
+		if (edge_pool.release(e)) // the old slot is released out of time order, reclaim the slab if it becomes sparse.
+			edge_pool.compact(e, this);
+		return moved;
+	}
+
+	void relocate(sg_edge* e, sg_edge* moved) // copy an edge to the memory of moved, and redirect the cross lists and the edge index to the copy. Called by move_edge and the compaction of the edge pool.
+	{
+		new (moved) sg_edge(*e);
+		if (e->src_prev)
+			e->src_prev->src_next = moved;
+		else
+			g[e->s].find(e->label)->list_head = moved;
+		if (e->src_next)
+			e->src_next->src_prev = moved;
+		if (e->dst_prev)
+			e->dst_prev->dst_next = moved;
+		else
+			rg[e->d].find(e->label)->list_head = moved;
+		if (e->dst_next)
+			e->dst_next->dst_prev = moved;
+		index.replace(e, moved);
 	}
 
 	void expire_edge(sg_edge* edge_to_delete) // this function deletes an expired edge from the streaming graph.
 	{
 		edge_num--;
+		index.erase(edge_to_delete);
+		neighbor_list& src_list = g[edge_to_delete->s];
+		label_list* list = src_list.find(edge_to_delete->label);
+		list->degree--;
 		if(edge_to_delete->src_prev)	// If this edge is not the head of the neighbor list, we split it from the neighbor list.
 		{
 			edge_to_delete->src_prev->src_next = edge_to_delete->src_next;
@@ -215,15 +675,17 @@ public:
 		}
 		else  // otherwise we need to change the head of the nighbor list to the next edge
 		{
-			unordered_map<unsigned int, neighbor_list>::iterator it = g.find(edge_to_delete->s);
 			if(edge_to_delete->src_next){
-				it->second.list_head = edge_to_delete->src_next;
+				list->list_head = edge_to_delete->src_next;
 				edge_to_delete->src_next->src_prev = NULL;
 			}
-			else  // if there is no next edge, this neighbor list is empty, and we can delete it.
-			g.erase(it);
+			else // if there is no next edge, the list of this label is empty, and we can delete it.
+				src_list.erase(edge_to_delete->label);
 		}
 		
+		neighbor_list& dst_list = rg[edge_to_delete->d];
+		list = dst_list.find(edge_to_delete->label);
+		list->degree--;
 		if(edge_to_delete->dst_prev)  // update the neighbor list of the destination vertex, similar to the update in for the source vertex.
 		{
 			edge_to_delete->dst_prev->dst_next = edge_to_delete->dst_next;
@@ -232,208 +694,252 @@ public:
 		}
 		else
 		{
-			unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(edge_to_delete->d);
 			if(edge_to_delete->dst_next){
-				it->second.list_head = edge_to_delete->dst_next;
+				list->list_head = edge_to_delete->dst_next;
 				edge_to_delete->dst_next->dst_prev = NULL;
 			}
 			else
-				rg.erase(it);
+				dst_list.erase(edge_to_delete->label);
 		}
 		return;
 	}
 
 	void expire(unsigned int timestamp, vector<edge_info >& deleted_edges) // this function is used to find all expired edges and remove them from the graph.
 	{
-		while (time_list_head)
+		while (sg_edge* cur = edge_pool.front()) // the oldest edge in the window
 		{
-			sg_edge* cur = time_list_head->edge_pt;
 			if (cur->timestamp + window_size - window_slide >= timestamp) // The later edges are still in the sliding window, and we can stop the expiration.
 				break;
 			expire_edge(cur);
 			deleted_edges.push_back(edge_info(cur->s, cur->d, cur->timestamp, cur->label)); // we record the information of expired edges. This information will be used to find expired tree nodes in S-PATH or LM-SRPQ.
-			timed_edge* tmp = time_list_head;
-			time_list_head = time_list_head->next;	// delete the time sequence list unit
-			if (time_list_head)
-				time_list_head->prev = NULL;
-			delete tmp;
-			delete cur;
+			if (g[cur->s].lists.empty() && rg[cur->s].lists.empty()) // the vertex has no edge in the window.
+				leave_window(cur->s);
+			if (cur->d != cur->s && g[cur->d].lists.empty() && rg[cur->d].lists.empty())
+				leave_window(cur->d);
+			edge_pool.release(cur);
 		}
-		if (!time_list_head) // if the list is empty, the tail pointer should also be NULL;
-			time_list_tail = NULL;
+		if (use_snapshot)
+			build_snapshot();
 	}
-	void get_suc(unsigned int s, int label, vector<unsigned int>& sucs) // get the successors of s, connected by edges with given label 
+	void enter_window(unsigned int v) // record a vertex which gets an edge in the window.
+	{
+		if (window_pos[v] != (unsigned int)-1)
+			return;
+		window_pos[v] = window_vertices.size();
+		window_vertices.push_back(v);
+		window_sorted = false;
+	}
+	void leave_window(unsigned int v) // called when the last edge of a vertex expires.
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
-		if (it != g.end())
+		unsigned int last = window_vertices.back();
+		window_vertices[window_pos[v]] = last;
+		window_pos[last] = window_pos[v];
+		window_vertices.pop_back();
+		window_pos[v] = -1;
+		window_sorted = false;
+	}
+	const vector<unsigned int>& vertices_in_window() // the vertices with edges in the window, in the order of internal IDs, which is the order of a scan over g. The cost is linear in the number of vertices in the window, not all the vertices seen in the stream.
+	{
+		if (!window_sorted)
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			sort(window_vertices.begin(), window_vertices.end());
+			for (unsigned int i = 0; i < window_vertices.size(); i++)
+				window_pos[window_vertices[i]] = i;
+			window_sorted = true;
+		}
+		return window_vertices;
+	}
+	void build_snapshot() // copy the successor lists into the CSR snapshot, called after the expiration of each window slide.
+	{
+		snapshot.offsets.resize(g.size() + 1);
+		snapshot.group_label.clear();
+		snapshot.group_start.clear();
+		snapshot.dst.resize(edge_num);
+		snapshot.timestamp.resize(edge_num);
+		unsigned int pos = 0;
+		for (unsigned int v = 0; v < g.size(); v++)
+		{
+			snapshot.offsets[v] = snapshot.group_label.size();
+			for (unsigned int i = 0; i < g[v].lists.size(); i++) // the edges are copied in the same order as the scan of the cross lists, each label list becomes a group.
 			{
-				if (tmp->label == label)
-					sucs.push_back(tmp->d);
-				tmp = tmp->src_next;
+				if (!g[v].lists[i].list_head)
+					continue;
+				snapshot.group_label.push_back(g[v].lists[i].label);
+				snapshot.group_start.push_back(pos);
+				for (sg_edge* tmp = g[v].lists[i].list_head; tmp; tmp = tmp->src_next)
+				{
+					snapshot.dst[pos] = tmp->d;
+					snapshot.timestamp[pos] = tmp->timestamp;
+					pos++;
+				}
 			}
 		}
+		snapshot.offsets[g.size()] = snapshot.group_label.size();
+		snapshot.group_start.push_back(pos);
+		snapshot.dirty.assign(g.size(), false);
+		snapshot.dirty_list.clear();
+		snapshot.valid = true;
+	}
+	void get_suc(unsigned int s, int label, vector<unsigned int>& sucs) // get the successors of s, connected by edges with given label 
+	{
+		if (s < g.size())
+		{
+			label_list* list = g[s].find(label); // only the list of this label is scanned
+			if (!list)
+				return;
+			for (sg_edge* tmp = list->list_head; tmp; tmp = tmp->src_next)
+				sucs.push_back(tmp->d);
+		}
 		return;
 	}
 	void get_prev(unsigned int d, int label, vector<unsigned int>& prevs) // get the precursors of d, connected by edges with given label 
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(d);
-		if (it != rg.end())
+		if (d < rg.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
-			{
-				if (tmp->label == label)
-					prevs.push_back(tmp->s);
-				tmp = tmp->dst_next;
-			}
+			label_list* list = rg[d].find(label);
+			if (!list)
+				return;
+			for (sg_edge* tmp = list->list_head; tmp; tmp = tmp->dst_next)
+				prevs.push_back(tmp->s);
 		}
 		return;
 	}
 	void get_all_suc(unsigned int s, vector<pair<unsigned int, unsigned int> >& sucs) // get all the successors, each pair is successor node ID + edge label
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
-		if (it != g.end())
+		if (s < g.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			for (unsigned int i = 0; i < g[s].lists.size(); i++)
 			{
-				sucs.push_back(make_pair(tmp->d, tmp->label));
-				tmp = tmp->src_next;
+				for (sg_edge* tmp = g[s].lists[i].list_head; tmp; tmp = tmp->src_next)
+					sucs.push_back(make_pair(tmp->d, tmp->label));
 			}
 		}
 	}
 	void get_all_prev(unsigned int d, vector<pair<unsigned int, unsigned int> >& prevs)// get all the precursors, each pair is precursor node ID + edge label
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(d);
-		if (it != rg.end())
+		if (d < rg.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			for (unsigned int i = 0; i < rg[d].lists.size(); i++)
 			{
-				prevs.push_back(make_pair(tmp->s, tmp->label));
-				tmp = tmp->dst_next;
+				for (sg_edge* tmp = rg[d].lists[i].list_head; tmp; tmp = tmp->dst_next)
+					prevs.push_back(make_pair(tmp->s, tmp->label));
 			}
 		}
 	}
 	// the following functions are variant of the former 4 functions, except that timestamp information is also included. The reported result is stored with edge_info structure;
 	void get_timed_suc(unsigned int s, int label, vector<edge_info>& sucs)
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
-		if (it != g.end())
+		if (snapshot.contains(s))
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			unsigned int begin, end;
+			if (snapshot.find(s, label, begin, end)) // only the range of this label is read
 			{
-				if (tmp->label == label)
-					sucs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
-				tmp = tmp->src_next;
+				for (unsigned int i = begin; i < end; i++)
+					sucs.push_back(edge_info(s, snapshot.dst[i], snapshot.timestamp[i], label));
 			}
+			return;
+		}
+		if (s < g.size())
+		{
+			label_list* list = g[s].find(label);
+			if (!list)
+				return;
+			for (sg_edge* tmp = list->list_head; tmp; tmp = tmp->src_next)
+				sucs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
 		}
 		return;
 	}
 	void get_timed_prev(unsigned int d, int label, vector<edge_info>& prevs)
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(d);
-		if (it != rg.end())
+		if (d < rg.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
-			{
-				if (tmp->label == label)
-					prevs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
-				tmp = tmp->dst_next;
-			}
+			label_list* list = rg[d].find(label);
+			if (!list)
+				return;
+			for (sg_edge* tmp = list->list_head; tmp; tmp = tmp->dst_next)
+				prevs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
 		}
 		return;
 	}
 	void get_timed_all_suc(unsigned int s, vector<edge_info >& sucs)
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
-		if (it != g.end())
+		if (snapshot.contains(s)) // read the out edges from the snapshot if s has not changed since the last window slide.
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			for (unsigned int k = snapshot.offsets[s]; k < snapshot.offsets[s + 1]; k++)
 			{
-				sucs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
-				tmp = tmp->src_next;
+				for (unsigned int i = snapshot.group_start[k]; i < snapshot.group_start[k + 1]; i++)
+					sucs.push_back(edge_info(s, snapshot.dst[i], snapshot.timestamp[i], snapshot.group_label[k]));
+			}
+			return;
+		}
+		if (s < g.size())
+		{
+			for (unsigned int i = 0; i < g[s].lists.size(); i++)
+			{
+				for (sg_edge* tmp = g[s].lists[i].list_head; tmp; tmp = tmp->src_next)
+					sucs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
 			}
 		}
 	}
+	suc_iterator timed_all_suc(unsigned int s) // in place iteration of all the out edges of s, with the same order and information as get_timed_all_suc.
+	{
+		if (snapshot.contains(s))
+			return suc_iterator(s, &snapshot, NULL);
+		return suc_iterator(s, NULL, s < g.size() ? &g[s] : NULL);
+	}
 	void get_timed_all_prev(unsigned int d, vector<edge_info >& prevs)
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(d);
-		if (it != rg.end())
+		if (d < rg.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
+			for (unsigned int i = 0; i < rg[d].lists.size(); i++)
 			{
-				prevs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
-				tmp = tmp->dst_next;
+				for (sg_edge* tmp = rg[d].lists[i].list_head; tmp; tmp = tmp->dst_next)
+					prevs.push_back(edge_info(tmp->s, tmp->d, tmp->timestamp, tmp->label));
 			}
 		}
 	}
 
-	void get_src_degree(unsigned int s, map<unsigned int, unsigned int>& degree_map) // count the degree of out edges of a vertex s.
+	unsigned int get_src_degree(unsigned int s, int label) // count the degree of out edges of a vertex s with the given label, which is kept in the label list.
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = g.find(s);
-		if (it != g.end())
+		if (s < g.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
-			{
-				if (degree_map.find(tmp->label) != degree_map.end())
-					degree_map[tmp->label]++;
-				else
-					degree_map[tmp->label] = 1;
-				tmp = tmp->src_next;
-			}
+			label_list* list = g[s].find(label);
+			if (list)
+				return list->degree;
 		}
+		return 0;
 	}
 
-	void get_dst_degree(unsigned int d, map<unsigned int, unsigned int>& degree_map)// count the degree of in edges of a vertex d.
+	unsigned int get_dst_degree(unsigned int d, int label)// count the degree of in edges of a vertex d with the given label.
 	{
-		unordered_map<unsigned int, neighbor_list>::iterator it = rg.find(d);
-		if (it != g.end())
+		if (d < rg.size())
 		{
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
-			{
-				if (degree_map.find(tmp->label) != degree_map.end())
-					degree_map[tmp->label]++;
-				else
-					degree_map[tmp->label] = 1;
-				tmp = tmp->dst_next;
-			}
+			label_list* list = rg[d].find(label);
+			if (list)
+				return list->degree;
 		}
+		return 0;
 	}
 
 
 	unsigned int compute_memory() // compute the memory of the streaming graph.
 	{
-		unsigned int total_memory = sizeof(unordered_map<unsigned long long, neighbor_list>)*2 + 4*2 + 8*2; // memory of the two unordered_map, two integer (window size and edge num), two pointer (head and tail pointer of the time sequence list)
-		total_memory += g.size() * 24 + g.bucket_count() * 8; // each KV has 16 byte, plus a pointer of 8 byte. Each bucket has another pointer, points to the KV pair list.
-		total_memory += rg.size() * 24 + rg.bucket_count() * 8;
-		total_memory += edge_num * (56 + 24); // each edge has two structure, 56 byte for the sg_edge and 24 byte for the timed_edge;
+		unsigned int total_memory = sizeof(vector<neighbor_list>)*2 + 4*3; // memory of the two vectors, three integer (window size, window slide and edge num)
+		total_memory += (g.capacity() + rg.capacity()) * 24; // each neighbor list is a vector of 24 byte.
+		for (unsigned int i = 0; i < g.size(); i++)
+			total_memory += (g[i].lists.capacity() + rg[i].lists.capacity()) * 16; // each label list has 16 byte, label, degree and the head pointer.
+		total_memory += dict.compute_memory();
+		total_memory += (window_vertices.capacity() + window_pos.capacity()) * 4;
+		total_memory += edge_pool.compute_memory(); // each edge has 48 byte, allocated in the memory pool.
+		if (use_snapshot)
+			total_memory += snapshot.compute_memory();
+		total_memory += index.compute_memory(); // each edge has a slot in the edge index, with load factor between 1/8 and 1/2
 		return total_memory;
 	}
 
 	unsigned int get_vertice_num() // count the number of vertices in the streaming graph
 	{
-		unordered_set<unsigned int> S;
-		for (unordered_map<unsigned int, neighbor_list>::iterator it = g.begin(); it != g.end(); it++)
-		{
-			S.insert(it->first);
-			sg_edge* tmp = it->second.list_head;
-			while (tmp)
-			{
-				S.insert(tmp->d);
-				tmp = tmp->src_next;
-			}
-		}
-		return S.size();
+		return window_vertices.size();
 	}
 
 	unsigned int get_edge_num() // return the number of edges in the streaming graph.
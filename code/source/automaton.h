@@ -8,6 +8,7 @@
 using namespace std;
 
 // this file defines the DFA struture 
+#define max_compiled_label 65536 // labels in the compiled transition table are remapped with a vector indexed by the label, thus the labels should be in [0, max_compiled_label]
 struct automat_edge // structure for neighbor list in the DFA 
 {
 	int state; // state of the neighbor
@@ -27,7 +28,18 @@ public:
 	unordered_map<int, automat_edge*> g; // the successor edge list of each state 
 	unordered_map<int, automat_edge*> rg;	// the precessor edge list of eeach state;
 	unordered_set<unsigned int> acceptable_labels; // record set of edge labels acceptable to the DFA, represented in number
-	automaton(int fs = 0) { final_state.insert(fs); }
+	// compiled form of the DFA, built by compile() after the query is constructed, and dropped when the DFA is modified. 
+	bool compiled;
+	vector<int> label_map; // maps a label to its index in the compact alphabet, -1 if the label is not acceptable
+	int alphabet_size;
+	int state_num; // states are in [0, state_num)
+	vector<int> trans; // dense state x label transition table, trans[s * alphabet_size + l] is the dst state of s receiving label l, -1 if there is no such transition
+	vector<unsigned long long> final_bits; // bitset of the final states
+	vector<vector<pair<int, int> > > state_pairs; // for each label in the compact alphabet, the (src state, dst state) pairs that accept this label, the same as the output of get_possible_state
+	unordered_map<int, vector<pair<int, int> > > pair_cache; // state pairs of each label when the DFA is not compiled, filled on demand and cleared when the DFA is modified.
+	vector<pair<int, int> > no_pairs; // an empty list, returned for labels not acceptable to the DFA
+
+	automaton(int fs = 0) { final_state.insert(fs); compiled = false; alphabet_size = 0; state_num = 0; }
 	~automaton()
 	{
 		unordered_map<int, automat_edge*>::iterator it;
@@ -59,13 +71,80 @@ public:
 	void set_final_state(int fs) // set state fs as a final state
 	{
 		final_state.insert(fs);
+		compiled = false;
 	}
 	bool check_final_state(int fs) // check if fs is a final state
 	{
+		if (compiled)
+			return fs >= 0 && fs < state_num && (final_bits[fs >> 6] >> (fs & 63) & 1);
 		return (final_state.find(fs)!=final_state.end());
 	}
+	bool compile() // build the transition table, the compact alphabet and the final state bitset. It returns false if the states or labels are out of range of the table, then the DFA keeps using the neighbor lists.
+	{
+		compiled = false;
+		int max_label = -1;
+		state_num = 0;
+		for (unordered_set<int>::iterator it = final_state.begin(); it != final_state.end(); it++)
+		{
+			if (*it < 0)
+				return false;
+			state_num = max(state_num, *it + 1);
+		}
+		for (unordered_map<int, automat_edge*>::iterator it = g.begin(); it != g.end(); it++)
+		{
+			for (automat_edge* tmp = it->second; tmp; tmp = tmp->next)
+			{
+				if (it->first < 0 || tmp->state < 0 || tmp->label < 0 || tmp->label > max_compiled_label)
+					return false;
+				state_num = max(state_num, max(it->first, tmp->state) + 1);
+				max_label = max(max_label, tmp->label);
+			}
+		}
+		label_map.assign(max_label + 1, -1);
+		alphabet_size = 0;
+		for (unordered_map<int, automat_edge*>::iterator it = g.begin(); it != g.end(); it++)
+		{
+			for (automat_edge* tmp = it->second; tmp; tmp = tmp->next)
+			{
+				if (label_map[tmp->label] == -1)
+					label_map[tmp->label] = alphabet_size++;
+			}
+		}
+		trans.assign(state_num * alphabet_size, -1);
+		for (int s = 0; s < state_num; s++)
+		{
+			unordered_map<int, automat_edge*>::iterator it = g.find(s);
+			if (it == g.end())
+				continue;
+			for (automat_edge* tmp = it->second; tmp; tmp = tmp->next) // the first edge in the list wins, the same as the scan in get_suc
+			{
+				int& dst = trans[s * alphabet_size + label_map[tmp->label]];
+				if (dst == -1)
+					dst = tmp->state;
+			}
+		}
+		final_bits.assign((state_num + 63) / 64, 0);
+		for (unordered_set<int>::iterator it = final_state.begin(); it != final_state.end(); it++)
+			final_bits[*it >> 6] |= (1ULL << (*it & 63));
+		state_pairs.assign(alphabet_size, vector<pair<int, int> >());
+		for (int l = 0; l <= max_label; l++)
+		{
+			if (label_map[l] != -1)
+				get_possible_state(l, state_pairs[label_map[l]]); // computed before compiled is set, thus it scans the neighbor lists.
+		}
+		compiled = true;
+		return true;
+	}
+	int compact_label(int label) // index of a label in the compact alphabet, -1 if it is not acceptable.
+	{
+		if (label < 0 || label >= (int)label_map.size())
+			return -1;
+		return label_map[label];
+	}
 	void insert_edge(int s, int d, int label) // insert an edge, indicating state s transfers to state d after receiving label
 	{
+		compiled = false;
+		pair_cache.clear();
 		acceptable_labels.insert(label);
 		unordered_map<int, automat_edge*>::iterator it = g.find(s);
 		if (it != g.end())
@@ -123,6 +202,8 @@ public:
 	}
 	bool delete_edge(int s, int d, int label) // delete a given edge; 
 	{
+		compiled = false;
+		pair_cache.clear();
 		unordered_map<int, automat_edge*>::iterator it = g.find(s);
 		if (it != g.end())
 		{
@@ -196,6 +277,13 @@ public:
 	}
 	void get_possible_state(int label, vector<pair<int, int>>& vec) // get all the state that can has out-edge with the given label, and their dst state
 	{
+		if (compiled)
+		{
+			int l = compact_label(label);
+			if (l != -1)
+				vec.insert(vec.end(), state_pairs[l].begin(), state_pairs[l].end());
+			return;
+		}
 		for (unordered_map<int, automat_edge*>::iterator iter = g.begin(); iter != g.end(); iter++)
 		{
 			automat_edge* tmp = iter->second;
@@ -210,8 +298,30 @@ public:
 			}
 		}
 	}
+	const vector<pair<int, int> >& get_state_pairs(int label) // the same state pairs as get_possible_state, but returned by reference to a cached list instead of being copied into a new vector. The reference is valid until the DFA is modified.
+	{
+		if (compiled)
+		{
+			int l = compact_label(label);
+			return l == -1 ? no_pairs : state_pairs[l];
+		}
+		unordered_map<int, vector<pair<int, int> > >::iterator it = pair_cache.find(label);
+		if (it == pair_cache.end())
+		{
+			it = pair_cache.insert(make_pair(label, vector<pair<int, int> >())).first;
+			get_possible_state(label, it->second);
+		}
+		return it->second;
+	}
 	int get_suc(int s, int label) // get the destination state of s when receiving label. For a DFA, there will be only one such state
 	{
+		if (compiled) // O(1) lookup in the transition table
+		{
+			int l = compact_label(label);
+			if (l == -1 || s < 0 || s >= state_num)
+				return -1;
+			return trans[s * alphabet_size + l];
+		}
 		unordered_map<int, automat_edge*>::iterator it = g.find(s);
 		if (it != g.end())
 		{
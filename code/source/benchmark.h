@@ -0,0 +1,178 @@
+#pragma once
+#include<iostream>
+#include<fstream>
+#include<string>
+#include<vector>
+#include<chrono>
+#include "ingest_pipeline.h"
+#define hist_sub_bits 7 // each power of 2 of the latency histogram is split into 2^7 buckets, thus the relative error of a recorded value is below 1/128
+using namespace std;
+
+// this file defines the driver that feeds an edge stream to an algorithm and measures it, shared by all the algorithms in the demo.
+// An algorithm provides insert_edge(s, d, label, time), expire(time), count(fout) and result_pairs, and optionally dynamic_lm_select(candidate_rate, benefit_threshold), which is called after each expiration if it exists.
+
+class latency_histogram // streaming log-linear histogram of latencies in nanoseconds, in the style of HDR histograms. The memory is fixed, no matter how many values are recorded.
+{
+public:
+	vector<unsigned long long> counts;
+	unsigned long long total = 0;
+	unsigned long long max_value = 0;
+	double sum = 0;
+	latency_histogram()
+	{
+		counts.resize((64 - hist_sub_bits + 1) << hist_sub_bits, 0);
+	}
+	static unsigned int index(unsigned long long v) // values smaller than 2^hist_sub_bits have their own buckets, larger values share a bucket with values of the same leading hist_sub_bits + 1 bits.
+	{
+		if (v < (1ULL << hist_sub_bits))
+			return v;
+		unsigned int msb = 63 - __builtin_clzll(v);
+		unsigned int group = msb - hist_sub_bits + 1;
+		return (group << hist_sub_bits) + ((v >> (msb - hist_sub_bits)) - (1ULL << hist_sub_bits));
+	}
+	static unsigned long long highest_value(unsigned int i) // largest value that falls in bucket i
+	{
+		unsigned int group = i >> hist_sub_bits;
+		unsigned long long r = i & ((1 << hist_sub_bits) - 1);
+		if (group == 0)
+			return r;
+		unsigned int shift = group - 1;
+		return (((1ULL << hist_sub_bits) + r + 1) << shift) - 1;
+	}
+	void record(unsigned long long v)
+	{
+		counts[index(v)]++;
+		total++;
+		sum += v;
+		if (v > max_value)
+			max_value = v;
+	}
+	unsigned long long percentile(double p) // smallest recorded bucket value such that p percent of the values are not larger than it
+	{
+		if (total == 0)
+			return 0;
+		unsigned long long target = (unsigned long long)(p / 100 * total);
+		if (target == 0)
+			target = 1;
+		unsigned long long cumulative = 0;
+		for (unsigned int i = 0; i < counts.size(); i++)
+		{
+			cumulative += counts[i];
+			if (cumulative >= target)
+				return highest_value(i) < max_value ? highest_value(i) : max_value;
+		}
+		return max_value;
+	}
+	double mean()
+	{
+		return total ? sum / total : 0;
+	}
+	void output_cdf(ofstream& fout) // one line for each non-empty bucket: the largest latency of the bucket and the fraction of the values not larger than it.
+	{
+		unsigned long long cumulative = 0;
+		for (unsigned int i = 0; i < counts.size(); i++)
+		{
+			if (!counts[i])
+				continue;
+			cumulative += counts[i];
+			unsigned long long v = highest_value(i) < max_value ? highest_value(i) : max_value;
+			fout << v << " " << (double)cumulative / total << endl;
+		}
+	}
+};
+
+struct run_report // measurement of a run
+{
+	string algorithm;
+	string data_path;
+	unsigned int window = 0; // window size and slide, in seconds
+	unsigned int slide = 0;
+	unsigned long long stream_edges = 0; // all the edges read from the stream
+	unsigned long long engine_edges = 0; // edges passed to the algorithm by the label filter
+	double seconds = 0; // wall-clock time of the run, including expiration and landmark selection
+	unsigned long long result_pairs = 0; // size of the result set at the end of the stream
+	latency_histogram latency; // insertion latency of the edges passed to the algorithm
+	double throughput()
+	{
+		return seconds > 0 ? stream_edges / seconds : 0;
+	}
+};
+
+template <class T>
+auto call_lm_select(T* f, double candidate_rate, double benefit_threshold, int) -> decltype(f->dynamic_lm_select(candidate_rate, benefit_threshold), void())
+{
+	f->dynamic_lm_select(candidate_rate, benefit_threshold);
+}
+
+template <class T>
+void call_lm_select(T*, double, double, long) {} // algorithms without landmarks
+
+template <class T>
+void run_benchmark(T* f, ingest_pipeline& fin, run_report& report, ofstream& memory_out, unsigned int checkpoint_slices, double candidate_rate, double benefit_threshold)
+	// feed the stream to algorithm f. The window slides when the first edge of a new slice arrives, and the memory is output every checkpoint_slices slices.
+{
+	unsigned int s, d, l;
+	unsigned long long t;
+	unsigned long long t0 = 0;
+	unsigned int slice = 0;
+	unsigned long long engine_edges = 0;
+	auto start = chrono::steady_clock::now();
+	while (fin.next(s, d, l, t))
+	{
+		engine_edges++;
+		if (t0 == 0)
+			t0 = t;
+		unsigned int time = t - t0 + 1;
+		auto insertion_start = chrono::steady_clock::now();
+		f->insert_edge(s, d, l, time);
+		auto insertion_end = chrono::steady_clock::now();
+		report.latency.record(chrono::duration_cast<chrono::nanoseconds>(insertion_end - insertion_start).count());
+		if (report.slide && time / report.slide > slice)
+		{
+			slice++;
+			f->expire(time);
+			call_lm_select(f, candidate_rate, benefit_threshold, 0);
+			if (checkpoint_slices && slice % checkpoint_slices == 0)
+				f->count(memory_out); // a checkpoint
+		}
+	}
+	auto finish = chrono::steady_clock::now();
+	report.seconds = chrono::duration_cast<chrono::nanoseconds>(finish - start).count() / 1e9;
+	report.stream_edges = fin.read_num;
+	report.engine_edges = engine_edges;
+	report.result_pairs = f->result_pairs.size();
+}
+
+inline void write_report(run_report& r, const string& prefix, const string& name)
+	// output the report of a run: name-speed.txt and name-insertion-latency.txt (the latency distribution) for reading, name-run.json for scripts,
+	// and a row appended to runs.csv, which collects all the runs in the directory.
+{
+	cout << r.algorithm << " time used " << r.seconds << " s" << endl;
+	cout << r.algorithm << " speed " << r.throughput() << " edges/s" << endl;
+	cout << r.algorithm << " insertion latency p50 " << r.latency.percentile(50) << " ns, p99 " << r.latency.percentile(99) << " ns, p99.9 " << r.latency.percentile(99.9) << " ns, max " << r.latency.max_value << " ns" << endl;
+
+	ofstream fspeed((prefix + name + "-speed.txt").c_str());
+	fspeed << r.algorithm << " time used " << r.seconds << endl;
+	fspeed << r.algorithm << " speed " << r.throughput() << endl;
+	fspeed.close();
+
+	ofstream flatency((prefix + name + "-insertion-latency.txt").c_str());
+	r.latency.output_cdf(flatency);
+	flatency.close();
+
+	ofstream fjson((prefix + name + "-run.json").c_str());
+	fjson << "{\"algorithm\": \"" << r.algorithm << "\", \"data\": \"" << r.data_path << "\", \"window_s\": " << r.window << ", \"slide_s\": " << r.slide
+		<< ", \"stream_edges\": " << r.stream_edges << ", \"engine_edges\": " << r.engine_edges << ", \"seconds\": " << r.seconds << ", \"edges_per_second\": " << r.throughput()
+		<< ", \"result_pairs\": " << r.result_pairs << ", \"latency_ns\": {\"count\": " << r.latency.total << ", \"mean\": " << r.latency.mean() << ", \"p50\": " << r.latency.percentile(50)
+		<< ", \"p99\": " << r.latency.percentile(99) << ", \"p999\": " << r.latency.percentile(99.9) << ", \"max\": " << r.latency.max_value << "}}" << endl;
+	fjson.close();
+
+	string csv_path = prefix + "runs.csv";
+	bool exists = ifstream(csv_path.c_str()).good();
+	ofstream fcsv(csv_path.c_str(), ios::app);
+	if (!exists)
+		fcsv << "algorithm,data,window_s,slide_s,stream_edges,engine_edges,seconds,edges_per_second,result_pairs,latency_mean_ns,latency_p50_ns,latency_p99_ns,latency_p999_ns,latency_max_ns" << endl;
+	fcsv << r.algorithm << "," << r.data_path << "," << r.window << "," << r.slide << "," << r.stream_edges << "," << r.engine_edges << "," << r.seconds << "," << r.throughput() << ","
+		<< r.result_pairs << "," << r.latency.mean() << "," << r.latency.percentile(50) << "," << r.latency.percentile(99) << "," << r.latency.percentile(99.9) << "," << r.latency.max_value << endl;
+	fcsv.close();
+}
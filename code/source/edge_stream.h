@@ -0,0 +1,140 @@
+#pragma once
+#include<iostream>
+#include<fstream>
+#include<string>
+#include<string.h>
+#include<climits>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#define edge_log_magic "RPQEDGE1" // first 8 bytes of a binary edge log
+#define edge_log_header_size 16 // magic + 8 byte edge number
+using namespace std;
+
+// this file defines the binary edge log and the reader of edge streams. The text format has one edge per row, "src_id dst_id label timestamp".
+// The binary edge log has a 16 byte header (the magic and the number of edges), followed by fixed 16 byte records, each with 4 byte src, dst, label and timestamp in native byte order.
+// The binary log is mapped into memory and read in place, thus reading an edge needs no system call and no parsing.
+
+struct edge_record // record of an edge in the binary edge log
+{
+	unsigned int src;
+	unsigned int dst;
+	unsigned int label;
+	unsigned int timestamp; // Unix time, which fits in 4 bytes
+};
+
+class edge_stream // reads edges from a binary edge log if the file starts with the magic, otherwise from a text file like before.
+{
+public:
+	ifstream fin; // used for text files
+	const edge_record* records = NULL; // records of a mapped binary edge log
+	unsigned long long edge_num = 0; // number of records in the binary edge log
+	unsigned long long pos = 0; // next record to read
+	void* mapped = NULL;
+	size_t mapped_size = 0;
+	bool binary = false;
+
+	edge_stream(const string& path)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			struct stat st;
+			char magic[8];
+			if (fstat(fd, &st) == 0 && st.st_size >= edge_log_header_size && pread(fd, magic, 8, 0) == 8 && memcmp(magic, edge_log_magic, 8) == 0)
+			{
+				void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED)
+				{
+					mapped = p;
+					mapped_size = st.st_size;
+					binary = true;
+					madvise(mapped, mapped_size, MADV_SEQUENTIAL); // the log is read once from the beginning to the end, let the kernel read ahead.
+					memcpy(&edge_num, (char*)mapped + 8, 8);
+					unsigned long long stored = (mapped_size - edge_log_header_size) / sizeof(edge_record);
+					if (edge_num > stored) // truncated log, read the complete records only
+						edge_num = stored;
+					records = (const edge_record*)((char*)mapped + edge_log_header_size);
+				}
+			}
+			close(fd); // the mapping stays valid after the file is closed
+		}
+		if (!binary)
+			fin.open(path.c_str());
+	}
+	~edge_stream()
+	{
+		if (mapped)
+			munmap(mapped, mapped_size);
+	}
+	bool is_open()
+	{
+		return binary || fin.is_open();
+	}
+	bool next(unsigned int& s, unsigned int& d, unsigned int& l, unsigned long long& t) // read the next edge, return false at the end of the stream.
+	{
+		if (binary)
+		{
+			if (pos >= edge_num)
+				return false;
+			const edge_record& r = records[pos++];
+			s = r.src;
+			d = r.dst;
+			l = r.label;
+			t = r.timestamp;
+			return true;
+		}
+		return (bool)(fin >> s >> d >> l >> t);
+	}
+	static bool convert(const string& text_path, const string& binary_path, unsigned long long& n, string& error_msg) // convert a text edge file into a binary edge log, edges are written in the order of the text file.
+		// return false and set error_msg if a file cannot be opened or written, a row cannot be parsed, or a timestamp does not fit in the 4 byte field. n is the number of edges written.
+	{
+		n = 0;
+		ifstream in(text_path.c_str());
+		if (!in.is_open())
+		{
+			error_msg = "cannot open " + text_path;
+			return false;
+		}
+		ofstream out(binary_path.c_str(), ios::binary);
+		if (!out.is_open())
+		{
+			error_msg = "cannot open " + binary_path;
+			return false;
+		}
+		out.write(edge_log_magic, 8);
+		out.write((const char*)&n, 8); // the edge number is filled in at the end
+		unsigned int s, d, l;
+		unsigned long long t;
+		while (in >> s >> d >> l >> t)
+		{
+			if (t > UINT_MAX)
+			{
+				error_msg = "timestamp " + to_string(t) + " of edge " + to_string(n + 1) + " does not fit in 4 bytes";
+				return false;
+			}
+			edge_record r;
+			r.src = s;
+			r.dst = d;
+			r.label = l;
+			r.timestamp = t;
+			out.write((const char*)&r, sizeof(edge_record));
+			n++;
+		}
+		if (!in.eof())
+		{
+			error_msg = "cannot parse the row of edge " + to_string(n + 1);
+			return false;
+		}
+		out.seekp(8);
+		out.write((const char*)&n, 8);
+		out.close();
+		if (!out)
+		{
+			error_msg = "cannot write " + binary_path;
+			return false;
+		}
+		return true;
+	}
+};
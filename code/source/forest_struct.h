@@ -7,14 +7,28 @@
 #include<string>
 #include <queue>
 #include<stack>
+#include<deque>
+#include<vector>
 #include<assert.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<mutex>
 #include "StreamingGraph.h"
+#include "result_sink.h"
 #define um_shrink_threshold 2
 #define merge_long_long(s, d) (((unsigned long long)s<<32)|d)
 using namespace std;
 #define min(x, y) (x<y?x:y)
 #define max(x, y) (x>y?x:y)
 #define MAX_INT 0x7FFFFFFF
+#define node_index_inline 4 // number of slots stored inside a spanning tree, trees with no more nodes than this do not allocate a table on the heap
+#define node_index_min_capacity 16 // capacity of the heap table when a tree grows out of the inline slots
+#define info_table_min_capacity 16
+#define pool_chunk_max 4096 // largest number of objects in a chunk of a free_list_pool
+#define node_chunk_bits 12 // a chunk of tree nodes has 2^node_chunk_bits slots, the first slot is the header of the chunk
+#define node_chunk_max (1 << 20) // largest number of chunks of tree nodes, a node handle has node_chunk_bits bits for the slot and the other bits for the chunk
+#define result_table_min_capacity 16
+#define time_info_min_capacity 16 // capacity of a TI table when the first node is added, normal trees never allocate a table
 
 
 // this file defines the basic structures and associated functions shared by both S-PATH and LM-SRPQ. Note that some variables are not needed by S-PATH, and they will not be included in memory computation for S-PATH.
@@ -35,16 +49,89 @@ inline void shrink(unordered_set<K>& us) // this function shrinks the bucket num
 		us.reserve(us.size());
 }
 
-struct tree_node // node in the spanning tree
+template <class T>
+class free_list_pool // pool of objects with arbitrary lifetime, like the tree_info units. Objects are carved from chunks, released slots are linked into a free list and reused by later allocations.
+	// chunks are returned when the pool is destroyed. T should be trivially destructible, as the objects left in the pool are not destroyed in the destructor.
+{
+	struct free_slot
+	{
+		free_slot* next;
+	};
+public:
+	static const unsigned int slot_bytes = sizeof(T) > sizeof(free_slot) ? sizeof(T) : sizeof(free_slot);
+	vector<char*> chunks;
+	unsigned int chunk_size; // number of slots in the newest chunk, it doubles with each new chunk until pool_chunk_max.
+	unsigned int used; // number of slots that have been carved from the newest chunk.
+	unsigned int total_slots; // number of slots in all the chunks.
+	free_slot* free_head; // list of released slots.
+	free_list_pool()
+	{
+		chunk_size = 0;
+		used = 0;
+		total_slots = 0;
+		free_head = NULL;
+	}
+	~free_list_pool()
+	{
+		for (unsigned int i = 0; i < chunks.size(); i++)
+			delete[] chunks[i];
+	}
+	T* allocate() // return the memory of a new object, which should be constructed with placement new.
+	{
+		if (free_head)
+		{
+			free_slot* cur = free_head;
+			free_head = cur->next;
+			return (T*)cur;
+		}
+		if (used == chunk_size)
+		{
+			chunk_size = chunk_size == 0 ? 16 : min(chunk_size * 2, pool_chunk_max);
+			chunks.push_back(new char[(size_t)chunk_size * slot_bytes]);
+			total_slots += chunk_size;
+			used = 0;
+		}
+		return (T*)(chunks.back() + (size_t)(used++) * slot_bytes);
+	}
+	void release(T* p) // destroy an object and put its slot into the free list.
+	{
+		p->~T();
+		deallocate(p);
+	}
+	void deallocate(void* p) // put a slot into the free list, the object in it should be destroyed already.
+	{
+		free_slot* cur = (free_slot*)p;
+		cur->next = free_head;
+		free_head = cur;
+	}
+	unsigned int compute_memory()
+	{
+		return sizeof(free_list_pool) + chunks.capacity() * 8 + total_slots * slot_bytes;
+	}
+};
+
+struct tree_node;
+
+struct node_ref // 32-bit handle of a tree node, used in place of a pointer in the tree nodes and the node index. The high bits are the index of the chunk in the node chunk table, and the low bits are the slot in the chunk.
+	// handle 0 is NULL. A node_ref is assigned from and converted to tree_node*, thus it is used like a pointer.
+{
+	unsigned int handle;
+	node_ref& operator=(tree_node* p);
+	operator tree_node* () const;
+	tree_node* operator->() const;
+};
+
+struct tree_node // node in the spanning tree, 32 bytes, as the links are handles.
 {
 	unsigned int node_ID;
 	unsigned int edge_timestamp; // timestamp of the edge linked this node and its parent;
 	unsigned int timestamp; // timestamp of this node
-	unsigned int state;
-	bool lm; // indicating if this is a landmark. This bool is not needed in S-PATH and will not be calculated in memory usage. 
-	tree_node* parent;	// pointer to parent. As we may need to move a subtree from one parent to another, a parent pointer will accelerate this procedure, as suggested by the authors.
-	tree_node* child;
-	tree_node* brother;	// first child and list of brother, classic method for tree maintaining
+	unsigned int state : 31;
+	unsigned int lm : 1; // indicating if this is a landmark. This bit is not needed in S-PATH. It shares a word with the state.
+	node_ref parent;	// handle of the parent. As we may need to move a subtree from one parent to another, a parent pointer will accelerate this procedure, as suggested by the authors.
+	node_ref child;
+	node_ref brother;	// first child and list of brother, classic method for tree maintaining
+	node_ref prev_brother; // previous node in the child list of the parent, NULL for the first child. With it a node is unlinked from the child list in O(1), which matters for high-fanout nodes.
 	tree_node(unsigned int ID, unsigned int state_, unsigned int time, unsigned int edge_time)
 	{
 		node_ID = ID;
@@ -54,74 +141,678 @@ struct tree_node // node in the spanning tree
 		parent = NULL;
 		child = NULL;
 		brother = NULL;
+		prev_brother = NULL;
 		lm = false;
 	}
 };
+static_assert(sizeof(tree_node) == 32, "the size of a chunk of tree nodes must be a power of 2, as a chunk is found by aligning the address of a node");
+
+struct node_chunk_header // content of the first slot of a chunk of tree nodes
+{
+	unsigned int index; // index of the chunk in the node chunk table
+	unsigned int pos; // position of the chunk in the chunk list of its pool
+};
+
+inline tree_node** node_chunk_table() // table from chunk index to the address of the chunk, shared by the node pools of all the forests in the process. It is zero-initialized, and index 0 is never used, thus handle 0 resolves to NULL.
+{
+	static tree_node* table[node_chunk_max];
+	return table;
+}
+
+class node_chunk_registry // hands out the indices of the node chunk table. Pools of different forests may allocate chunks on different threads, while the worker threads of a forest only read the table.
+{
+public:
+	mutex lock;
+	vector<unsigned int> free_indices; // indices of returned chunks
+	unsigned int next_index = 1;
+	static node_chunk_registry& instance()
+	{
+		static node_chunk_registry registry;
+		return registry;
+	}
+	unsigned int add(tree_node* chunk)
+	{
+		lock_guard<mutex> guard(lock);
+		unsigned int index;
+		if (!free_indices.empty())
+		{
+			index = free_indices.back();
+			free_indices.pop_back();
+		}
+		else
+			index = next_index++;
+		assert(index < node_chunk_max);
+		node_chunk_table()[index] = chunk;
+		return index;
+	}
+	void remove(unsigned int index)
+	{
+		lock_guard<mutex> guard(lock);
+		node_chunk_table()[index] = NULL;
+		free_indices.push_back(index);
+	}
+};
+
+#define node_chunk_bytes (sizeof(tree_node) << node_chunk_bits)
+
+inline node_chunk_header* chunk_of(tree_node* p) // chunks are aligned to their size, thus the header of the chunk containing a node is found by masking the address.
+{
+	return (node_chunk_header*)((uintptr_t)p & ~(uintptr_t)(node_chunk_bytes - 1));
+}
+
+inline node_ref& node_ref::operator=(tree_node* p)
+{
+	if (!p)
+		handle = 0;
+	else
+		handle = chunk_of(p)->index << node_chunk_bits | (unsigned int)(p - (tree_node*)chunk_of(p));
+	return *this;
+}
+
+inline node_ref::operator tree_node* () const
+{
+	return node_chunk_table()[handle >> node_chunk_bits] + (handle & ((1 << node_chunk_bits) - 1));
+}
 
-struct tree_node_index //  maps a vertex ID to the tree node in a spanning tree
+inline tree_node* node_ref::operator->() const
 {
-	unordered_map<unsigned int, tree_node*> index;
+	return *this;
+}
+
+class tree_node_pool // pool of the tree nodes of a forest. Nodes are carved from aligned chunks registered in the node chunk table, so that they are linked with 32-bit handles.
+	// released nodes form a free list linked through their parent handles. A deleted subtree is put into the free list with its root only, and its other nodes follow when the root is reused, through the child and brother handles.
+	// when most of the slots are free, the chunks whose nodes are all free are returned.
+{
+public:
+	static const unsigned int chunk_slots = 1 << node_chunk_bits;
+	vector<tree_node*> chunks; // chunks of this pool, the last one is being carved.
+	unsigned int used; // slots carved from the last chunk, including the header.
+	node_ref free_head; // free list of nodes and deleted subtrees
+	unsigned int live; // number of nodes in use
+	unsigned int released; // number of nodes released since the last trim
+	tree_node_pool()
+	{
+		used = chunk_slots;
+		free_head = NULL;
+		live = 0;
+		released = 0;
+	}
+	~tree_node_pool()
+	{
+		for (unsigned int i = 0; i < chunks.size(); i++)
+			drop_chunk(chunks[i]);
+	}
+	tree_node* allocate() // return the memory of a new node, which should be constructed with placement new.
+	{
+		tree_node* p = free_head;
+		if (p)
+		{
+			free_head = p->parent;
+			push(p->child); // the rest of a deleted subtree stays in the free list.
+			push(p->brother);
+		}
+		else
+		{
+			if (used == chunk_slots)
+				add_chunk();
+			p = chunks.back() + used++;
+		}
+		live++;
+		return p;
+	}
+	void release(tree_node* p) // put a single node into the free list, its children and brothers are not released.
+	{
+		p->child = NULL;
+		p->brother = NULL;
+		push(p);
+		live--;
+		released++;
+		check_trim();
+	}
+	void release_subtree(tree_node* root, unsigned int node_num) // put a subtree into the free list in O(1). Its nodes should be removed from the indexes already, node_num is the number of nodes in it.
+	{
+		root->brother = NULL;
+		release_siblings(root, node_num);
+	}
+	void release_siblings(tree_node* first, unsigned int node_num) // put a node, the brothers after it and all their subtrees into the free list in O(1). node_num is the number of these nodes.
+	{
+		push(first);
+		live -= node_num;
+		released += node_num;
+		check_trim();
+	}
+	void push(tree_node* p)
+	{
+		if (p)
+		{
+			p->parent = free_head;
+			free_head = p;
+		}
+	}
+	void check_trim() // trim the pool when at least half of the slots have been released since the last trim and less than a quarter of the slots are in use, thus the cost of trim is amortized by the releases.
+	{
+		unsigned long long slots = (unsigned long long)chunks.size() * (chunk_slots - 1);
+		if (chunks.size() > 1 && released * 2 >= slots && live * 4 < slots)
+			trim();
+	}
+	void trim() // return the chunks whose nodes are all free, except the last chunk. The deleted subtrees in the free list are expanded, and the free list is rebuilt with the nodes in the kept chunks.
+	{
+		released = 0;
+		vector<tree_node*> free_nodes;
+		while (free_head)
+		{
+			tree_node* p = free_head;
+			free_head = p->parent;
+			push(p->child);
+			push(p->brother);
+			free_nodes.push_back(p);
+		}
+		vector<unsigned int> free_num(chunks.size(), 0);
+		for (unsigned int i = 0; i < free_nodes.size(); i++)
+			free_num[chunk_of(free_nodes[i])->pos]++;
+		unsigned int carved = (chunks.size() - 1) * (chunk_slots - 1) + used - 1;
+		live = carved - free_nodes.size();
+		vector<bool> dropped(chunks.size(), false);
+		for (unsigned int i = 0; i + 1 < chunks.size(); i++)
+			dropped[i] = free_num[i] == chunk_slots - 1;
+		for (unsigned int i = 0; i < free_nodes.size(); i++)
+		{
+			if (dropped[chunk_of(free_nodes[i])->pos])
+				continue;
+			free_nodes[i]->child = NULL;
+			free_nodes[i]->brother = NULL;
+			push(free_nodes[i]);
+		}
+		unsigned int k = 0;
+		for (unsigned int i = 0; i < chunks.size(); i++)
+		{
+			if (dropped[i])
+				drop_chunk(chunks[i]);
+			else
+			{
+				chunks[k] = chunks[i];
+				chunk_of(chunks[k])->pos = k;
+				k++;
+			}
+		}
+		chunks.resize(k);
+	}
+	void add_chunk()
+	{
+		void* mem = NULL;
+		if (posix_memalign(&mem, node_chunk_bytes, node_chunk_bytes) != 0)
+			throw bad_alloc();
+		tree_node* chunk = (tree_node*)mem;
+		node_chunk_header* header = (node_chunk_header*)chunk;
+		header->pos = chunks.size();
+		header->index = node_chunk_registry::instance().add(chunk);
+		chunks.push_back(chunk);
+		used = 1;
+	}
+	void drop_chunk(tree_node* chunk)
+	{
+		node_chunk_registry::instance().remove(chunk_of(chunk)->index);
+		free(chunk);
+	}
+	unsigned int compute_memory()
+	{
+		return sizeof(tree_node_pool) + chunks.capacity() * 8 + chunks.size() * node_chunk_bytes;
+	}
+};
+
+class tree_node_index // open addressing hash table that maps a product graph node (vertex ID, state) to the tree node in a spanning tree. The key is read from the tree node, thus each slot is only a node handle.
+	// small trees keep the nodes in the inline slots, which are scanned linearly. When the inline slots are full, the nodes are moved to a heap table with linear probing, where deletion is carried out with backward shift.
+{
+public:
+	node_ref* table; // slots of the table, NULL means an empty slot. It points to inline_slots for small trees.
+	unsigned int capacity; // number of slots, node_index_inline for the inline slots, otherwise a power of 2.
+	unsigned int size; // number of nodes in the table.
+	node_ref inline_slots[node_index_inline];
+	tree_node_index()
+	{
+		table = inline_slots;
+		capacity = node_index_inline;
+		size = 0;
+		for (unsigned int i = 0; i < node_index_inline; i++)
+			inline_slots[i] = NULL;
+	}
 	~tree_node_index()
 	{
-		index.clear();
+		if (table != inline_slots)
+			delete[] table;
+	}
+	static unsigned long long hash(unsigned int v, unsigned int state) // mix the product graph node ID into a 64-bit hash value.
+	{
+		unsigned long long h = merge_long_long(v, state);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+	tree_node* find(unsigned int v, unsigned int state) // return the tree node of (v, state), or NULL if it is not in the tree.
+	{
+		if (table == inline_slots)
+		{
+			for (unsigned int i = 0; i < node_index_inline; i++)
+			{
+				if (inline_slots[i] && inline_slots[i]->node_ID == v && inline_slots[i]->state == state)
+					return inline_slots[i];
+			}
+			return NULL;
+		}
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(v, state) & mask;
+		while (table[pos])
+		{
+			tree_node* cur = table[pos];
+			if (cur->node_ID == v && cur->state == state)
+				return cur;
+			pos = (pos + 1) & mask;
+		}
+		return NULL;
+	}
+	void insert(tree_node* node) // insert a new tree node, the caller guarantees that its product graph node is not in the table yet.
+	{
+		if (table == inline_slots)
+		{
+			if (size < node_index_inline)
+			{
+				unsigned int pos = 0;
+				while (inline_slots[pos])
+					pos++;
+				inline_slots[pos] = node;
+				size++;
+				return;
+			}
+			rehash(node_index_min_capacity);
+		}
+		else if ((size + 1) * 2 > capacity) // keep the load factor under 0.5, so that the probe sequences stay short.
+			rehash(capacity * 2);
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(node->node_ID, node->state) & mask;
+		while (table[pos])
+			pos = (pos + 1) & mask;
+		table[pos] = node;
+		size++;
+	}
+	tree_node* erase(unsigned int v, unsigned int state) // delete the tree node of (v, state) from the table and return it, or return NULL if it is not in the table.
+	{
+		if (table == inline_slots)
+		{
+			for (unsigned int i = 0; i < node_index_inline; i++)
+			{
+				if (inline_slots[i] && inline_slots[i]->node_ID == v && inline_slots[i]->state == state)
+				{
+					tree_node* ans = inline_slots[i];
+					inline_slots[i] = NULL;
+					size--;
+					return ans;
+				}
+			}
+			return NULL;
+		}
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(v, state) & mask;
+		while (table[pos] && (table[pos]->node_ID != v || table[pos]->state != state))
+			pos = (pos + 1) & mask;
+		tree_node* ans = table[pos];
+		if (!ans)
+			return NULL;
+		table[pos] = NULL;
+		size--;
+		unsigned int next = (pos + 1) & mask;
+		while (table[next]) // backward shift, move the following nodes in the cluster forward if their home slot is not in (pos, next]
+		{
+			unsigned int home = hash(table[next]->node_ID, table[next]->state) & mask;
+			if (((next - home) & mask) >= ((next - pos) & mask))
+			{
+				table[pos] = table[next];
+				table[next] = NULL;
+				pos = next;
+			}
+			next = (next + 1) & mask;
+		}
+		if (size * 8 < capacity) // shrink the table if it becomes too sparse, and move back to the inline slots when the tree is small enough.
+			rehash(size * 2 < node_index_inline ? node_index_inline : capacity / 2);
+		return ans;
+	}
+	void rehash(unsigned int new_capacity) // move all the nodes to a new table with the given capacity, node_index_inline means the inline slots.
+	{
+		node_ref* old_table = table;
+		unsigned int old_capacity = capacity;
+		capacity = new_capacity;
+		if (new_capacity == node_index_inline)
+		{
+			table = inline_slots;
+			unsigned int pos = 0;
+			for (unsigned int i = 0; i < old_capacity; i++)
+			{
+				if (old_table[i])
+					inline_slots[pos++] = old_table[i];
+			}
+			for (; pos < node_index_inline; pos++)
+				inline_slots[pos] = NULL;
+		}
+		else
+		{
+			table = new node_ref[capacity];
+			for (unsigned int i = 0; i < capacity; i++)
+				table[i] = NULL;
+			unsigned int mask = capacity - 1;
+			for (unsigned int i = 0; i < old_capacity; i++)
+			{
+				if (!old_table[i])
+					continue;
+				unsigned int pos = hash(old_table[i]->node_ID, old_table[i]->state) & mask;
+				while (table[pos])
+					pos = (pos + 1) & mask;
+				table[pos] = old_table[i];
+			}
+		}
+		if (old_table != inline_slots)
+			delete[] old_table;
+	}
+	void clear()
+	{
+		if (table != inline_slots)
+			delete[] table;
+		table = inline_slots;
+		capacity = node_index_inline;
+		size = 0;
+		for (unsigned int i = 0; i < node_index_inline; i++)
+			inline_slots[i] = NULL;
+	}
+	unsigned int compute_memory() // memory of the heap table, the inline slots are counted in the spanning tree.
+	{
+		return table == inline_slots ? 0 : capacity * 4;
+	}
+};
+struct split_key // an unsigned long long key stored as two unsigned ints, so that a slot holding the key and a timestamp takes 12 bytes with its natural 4-byte alignment.
+	// The key is only read and written by value, a reference to it as an unsigned long long would be misaligned.
+{
+	unsigned int low;
+	unsigned int high;
+	operator unsigned long long() const { return (unsigned long long)high << 32 | low; }
+	split_key& operator=(unsigned long long key)
+	{
+		low = (unsigned int)key;
+		high = (unsigned int)(key >> 32);
+		return *this;
 	}
 };
-struct time_info_index // maps a vertex ID to the timestamp in TI map;
+
+struct time_info_entry // slot of the TI table, 12 bytes. node is the product graph node (vertex ID, state) merged into an unsigned long long, time is its timestamp in the TI map.
+	// time 0 marks an empty slot, as a node not in the TI map has timestamp 0 and timestamps in the map are always positive.
 {
-	unordered_map<unsigned int, unsigned int> index;
-	~time_info_index()
+	split_key node;
+	unsigned int time;
+};
+
+class time_info_table // TI map of an LM tree, maps each product graph node reachable from the tree root to the largest timestamp of paths to it. All the nodes are stored in one open addressing table
+	// with linear probing and backward shift deletion, like result_set, so that a lookup is a single probe sequence. The table is allocated when the first node is added.
+	// The home slot of a node is taken from the high bits of its hash value, thus the nodes are laid out in the order of their hash values whatever the capacity is, except the few clusters that wrap around the end.
+	// Scanning one table and inserting its nodes into another one (merge, rehash) visits both tables from the beginning to the end, like merging two sorted arrays, instead of jumping around the target table.
+{
+public:
+	time_info_entry* table = NULL; // slots of the table, scanned directly by the callers that visit the whole TI map.
+	unsigned int capacity = 0; // number of slots, 0 or a power of 2.
+	unsigned int shift = 64; // 64 - log2(capacity), the home slot of a node is the hash value shifted right by this.
+	unsigned int entry_num = 0; // number of nodes in the table.
+
+	~time_info_table()
+	{
+		clear();
+	}
+	static unsigned long long hash(unsigned long long node)
 	{
-		index.clear();
+		unsigned long long h = node;
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
 	}
+	unsigned int home(unsigned long long node)
+	{
+		return hash(node) >> shift;
+	}
+	time_info_entry* find(unsigned long long node) // return the entry of the node, or NULL if it is not in the TI map.
+	{
+		if (!capacity)
+			return NULL;
+		unsigned int mask = capacity - 1;
+		unsigned int pos = home(node);
+		while (table[pos].time)
+		{
+			if (table[pos].node == node)
+				return &table[pos];
+			pos = (pos + 1) & mask;
+		}
+		return NULL;
+	}
+	unsigned int get(unsigned long long node) // timestamp of the node, 0 if it is not in the TI map.
+	{
+		time_info_entry* e = find(node);
+		return e ? e->time : 0;
+	}
+	time_info_entry* probe(unsigned long long node) // return the slot of the node, or the empty slot where it should be inserted. The table grows only when a new node is inserted,
+		// thus updating existing nodes never moves the entries, even if the table is being scanned.
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int pos = home(node);
+		while (table[pos].time && table[pos].node != node)
+			pos = (pos + 1) & mask;
+		if (table[pos].time || (entry_num + 1) * 2 <= capacity) // keep the load factor under 0.5, so that the probe sequences stay short.
+			return &table[pos];
+		rehash(capacity * 2);
+		mask = capacity - 1;
+		pos = home(node);
+		while (table[pos].time)
+			pos = (pos + 1) & mask;
+		return &table[pos];
+	}
+	void set(unsigned long long node, unsigned int time) // set the timestamp of the node, setting it to 0 deletes the node.
+	{
+		if (time == 0)
+		{
+			time_info_entry* e = find(node);
+			if (e)
+				erase(e);
+			return;
+		}
+		if (!capacity)
+			rehash(time_info_min_capacity);
+		time_info_entry* e = probe(node);
+		if (!e->time)
+			entry_num++;
+		e->node = node;
+		e->time = time;
+	}
+	bool raise(unsigned long long node, unsigned int time) // keep the larger timestamp of the node, return true if the TI map is changed. The slot is found with a single probe sequence, for both insertion and update.
+	{
+		if (time == 0)
+			return false;
+		if (!capacity)
+			rehash(time_info_min_capacity);
+		time_info_entry* e = probe(node);
+		if (e->time >= time)
+			return false;
+		if (!e->time)
+			entry_num++;
+		e->node = node;
+		e->time = time;
+		return true;
+	}
+	void reserve(unsigned int n) // grow the table so that n nodes fit in it without growing again.
+	{
+		unsigned int new_capacity = capacity ? capacity : time_info_min_capacity;
+		while (n * 2 > new_capacity)
+			new_capacity *= 2;
+		if (new_capacity != capacity)
+			rehash(new_capacity);
+	}
+	void merge(time_info_table& src, unsigned int cap, vector<time_info_entry>* delta) // raise each node of src to the smaller one of its timestamp in src and cap, and append the nodes whose timestamp is changed to delta if it is given.
+		// used when the TI map of a landmark is merged into the TI map of an LM tree containing it. The table is sized for both maps at once, and as src is scanned in the order of the hash values,
+		// the probes move forward through this table, so the merge is one linear pass over each table.
+	{
+		if (&src == this || !src.entry_num) // merging a map into itself never raises a timestamp
+			return;
+		reserve(entry_num + src.entry_num);
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = 0; i < src.capacity; i++)
+		{
+			if (!src.table[i].time)
+				continue;
+			unsigned long long node = src.table[i].node;
+			unsigned int time = min(src.table[i].time, cap);
+			unsigned int pos = home(node);
+			while (table[pos].time && table[pos].node != node)
+				pos = (pos + 1) & mask;
+			if (table[pos].time >= time)
+				continue;
+			if (!table[pos].time)
+				entry_num++;
+			table[pos].node = node;
+			table[pos].time = time;
+			if (delta)
+				delta->push_back(table[pos]);
+		}
+	}
+	void erase(time_info_entry* e) // delete the node in the given slot. The table is not shrunk here, as nodes are deleted in batches in expiration, call shrink after the batch.
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int pos = e - table;
+		table[pos].time = 0;
+		entry_num--;
+		unsigned int next = (pos + 1) & mask;
+		while (table[next].time) // backward shift, move the following nodes in the cluster forward if their home slot is not in (pos, next]
+		{
+			unsigned int h = home(table[next].node);
+			if (((next - h) & mask) >= ((next - pos) & mask))
+			{
+				table[pos] = table[next];
+				table[next].time = 0;
+				pos = next;
+			}
+			next = (next + 1) & mask;
+		}
+	}
+	void shrink() // shrink the table if it becomes too sparse, and free it when the TI map is empty.
+	{
+		if (!entry_num)
+		{
+			clear();
+			return;
+		}
+		unsigned int new_capacity = capacity;
+		while (new_capacity > time_info_min_capacity && entry_num * 8 < new_capacity)
+			new_capacity /= 2;
+		if (new_capacity != capacity)
+			rehash(new_capacity);
+	}
+	void rehash(unsigned int new_capacity) // move all the nodes to a new table with the given capacity.
+	{
+		time_info_entry* old_table = table;
+		unsigned int old_capacity = capacity;
+		capacity = new_capacity;
+		shift = 64 - __builtin_ctz(capacity);
+		table = new time_info_entry[capacity]();
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = 0; i < old_capacity; i++)
+		{
+			if (!old_table[i].time)
+				continue;
+			unsigned int pos = home(old_table[i].node);
+			while (table[pos].time)
+				pos = (pos + 1) & mask;
+			table[pos] = old_table[i];
+		}
+		if (old_table)
+			delete[] old_table;
+	}
+	void clear()
+	{
+		if (table)
+			delete[] table;
+		table = NULL;
+		capacity = 0;
+		shift = 64;
+		entry_num = 0;
+	}
+	bool empty()
+	{
+		return entry_num == 0;
+	}
+	unsigned int size()
+	{
+		return entry_num;
+	}
+	unsigned long long compute_memory() // memory of the heap table, the fields are counted in the spanning tree.
+	{
+		return (unsigned long long)capacity * sizeof(time_info_entry);
+	}
+};
+
+class RPQ_tree;
+
+struct lm_handle // a landmark in a normal tree, with the LM tree of the landmark and the tree node of the landmark in the normal tree, so that the TI map of the landmark can be read without looking up the forest and the node map.
+{
+	unsigned long long lm_info;
+	RPQ_tree* lm_tree;
+	tree_node* lm_node;
+};
+
+struct lm_handle_cache // handles of the landmarks of a normal tree, in the iteration order of its landmark set. It is valid while the landmark set and the forest do not change.
+{
+	vector<lm_handle> handles;
+	unsigned int lm_version; // lm_version of the tree when the handles are built
+	unsigned int forest_epoch; // epoch of the forest when the handles are built
 };
 
 class RPQ_tree // class for the spanning trees in the spanning forest.
 {
 public:
 	tree_node* root;
-	map<unsigned int, tree_node_index*> node_map; // map from a state to the relevant node index. In the node index the reverse map from vertex ID to the tree node pointer is stored. The state in the first layer an the vertex ID in the second layer form a product graph node ID 
-	map<unsigned int, time_info_index*> time_info; // TI map, used by LM-SRPQ, but not by S-PATH. Maps a state to the relevant time_info_index. In each the reverse index we map vertex ID to the timestamp in TI map.The state in the first layer an the vertex ID in the second layer form a product graph node ID 
+	tree_node_index node_map; // map from a product graph node (vertex ID, state) to the tree node.
+	time_info_table time_info; // TI map, used by LM-SRPQ, but not by S-PATH. Maps a product graph node (vertex ID and state merged with merge_long_long) to the timestamp of the latest path from the root to it.
 	unordered_set<unsigned long long> landmarks; // set of landmarks contained in this tree. Merge the vertex ID and state with merge_long_long. Used by LM-SRPQ.
 	unordered_map<unsigned long long, unsigned int> timed_landmarks; // this structure is used to directly get the landmarks and the timestamp of this landmark in the spanning tree. 
 	// This structure is used when we need to traverse forward in the dependency graph, and thus is only needed in the dependency-forest version of LM-SRPQ
 	int node_cnt;
+	unsigned int lm_version = 0; // increased whenever the landmark set changes, landmarks should only be added or deleted through the functions of this class.
+	lm_handle_cache* lm_cache = NULL; // built on demand by LM-SRPQ when the tree is visited as a normal tree
+	tree_node_pool* node_pool; // pool of the forest that owns this tree, the tree nodes are allocated from it, as nodes are added and deleted at a high rate when the window slides.
 
-	RPQ_tree()
+	RPQ_tree(tree_node_pool* node_pool_)
 	{
 		root = NULL;
 		node_cnt = 0;
+		node_pool = node_pool_;
 	}
 	void clear()
 	{
 		if (root) {
-			queue<tree_node*> q;
-			q.push(root);
-			while (!q.empty())
+			node_pool->release_subtree(root, node_map.size); // all the nodes are freed at once
+			node_map.clear();
+			if (!landmarks.empty()) // the cached landmark handles stay valid if there was no landmark.
 			{
-				tree_node* tmp = q.front();
-				q.pop();
-				tree_node* cur = tmp->child;
-				while (cur)
-				{
-					q.push(cur);
-					cur = cur->brother;
-				}
-				delete tmp;
+				landmarks.clear();
+				lm_version++;
 			}
-			for (map<unsigned int, tree_node_index*>::iterator iter = node_map.begin(); iter != node_map.end(); iter++)
-				delete iter->second;
-			for (map<unsigned int, time_info_index*>::iterator iter = time_info.begin(); iter != time_info.end(); iter++)
-				delete iter->second;
-			node_map.clear();
-			landmarks.clear();
 			time_info.clear();
 			root = NULL;
 		}
+		if (lm_cache)
+		{
+			delete lm_cache;
+			lm_cache = NULL;
+		}
 	}
 	void clear_time_info() // clear the TI map, used when a spanning tree is not an LM tree any more.
 	{
-		for (map<unsigned int, time_info_index*>::iterator iter = time_info.begin(); iter != time_info.end(); iter++)
-			delete iter->second;
 		time_info.clear();
 	}
 	~RPQ_tree()
@@ -130,86 +821,78 @@ public:
 	}
 	void add_time_info(unsigned int v, unsigned int state, unsigned int time) // add a product graph node ID + timestamp pair to the TI map
 	{
-		if (time_info.find(state) == time_info.end())
-			time_info[state] = new time_info_index;
-		time_info[state]->index[v] = time;
+		time_info.set(merge_long_long(v, state), time);
+	}
+	bool raise_time_info(unsigned int v, unsigned int state, unsigned int time) // set the timestamp of a product graph node in the TI map to time if time is larger, return true if the TI map is changed.
+		// it has the effect of get_time_info followed by add_time_info, but the node is only looked up once.
+	{
+		return time_info.raise(merge_long_long(v, state), time);
 	}
 	unsigned int get_time_info(unsigned int v, unsigned int state) // get the timestamp of a product graph node in the TI map
 	{
-		if (time_info.find(state) == time_info.end())
-			return 0;
-		if (time_info[state]->index.find(v) != time_info[state]->index.end())
-			return time_info[state]->index[v];
-		else
-			return 0;
+		return time_info.get(merge_long_long(v, state));
 	}
 	tree_node* add_node(unsigned int v, unsigned int state, tree_node* parent, unsigned int time, unsigned int edge_time) // add a new tree node with given ID, state, node time ,edge time and parent
 	{
-		tree_node* tmp = new tree_node(v, state, time, edge_time);
-		tmp->parent = parent;
-		if (parent) {
-			tmp->brother = parent->child; // add this node to the head of the child list of the parent
-			parent->child = tmp;
-		}
-		else
-			tmp->brother = NULL;
-		if (node_map.find(state) == node_map.end())
-			node_map[state] = new tree_node_index;
-		node_map[state]->index[v] = tmp; // add this node to the node map
+		tree_node* tmp = new (node_pool->allocate()) tree_node(v, state, time, edge_time);
+		if (parent)
+			link_child(parent, tmp); // add this node to the head of the child list of the parent
+		node_map.insert(tmp); // add this node to the node map
 		node_cnt++;
 		return tmp;
 	}
 	void set_lm(unsigned int v, unsigned int state) // set the LM tag of a node to true;
 	{
-		if (node_map.find(state) == node_map.end())
-			return;
-		else
-		{
-			if (node_map[state]->index.find(v) != node_map[state]->index.end())
-			{
-				tree_node* tmp = node_map[state]->index[v];
-				tmp->lm = true;
-			}
-		}
+		tree_node* tmp = node_map.find(v, state);
+		if (tmp)
+			tmp->lm = true;
 	}
 
 	void add_lm(unsigned long long lm) // add a node into the LM set.
 	{
-		landmarks.insert(lm);
+		if (landmarks.insert(lm).second)
+			lm_version++;
 	}
 	void add_timed_lm(unsigned long long lm, unsigned int timestamp)
 	{
 		timed_landmarks[lm] = timestamp;
 	}
+	void link_child(tree_node* parent, tree_node* child) // add a node to the head of the child list of parent.
+	{
+		child->parent = parent;
+		child->prev_brother = NULL;
+		child->brother = parent->child;
+		if (parent->child)
+			parent->child->prev_brother = child;
+		parent->child = child;
+	}
+	void unlink_child(tree_node* child) // split a node from the child list of its parent, its own brother pointer is kept, as callers may still be scanning the list.
+	{
+		if (child->prev_brother)
+			child->prev_brother->brother = child->brother;
+		else
+			child->parent->child = child->brother;
+		if (child->brother)
+			child->brother->prev_brother = child->prev_brother;
+		child->prev_brother = NULL;
+	}
 	void separate_node(tree_node* child) // separate a node from the spanning tree 
 	{
 		if (child->parent == NULL)
 			return;
-		if (child->parent->child == child) // find the node in the child list of the parent, and split it.
-			child->parent->child = child->brother;
-		else
-		{
-			tree_node* tmp = child->parent->child;
-			while (tmp != NULL && tmp->brother != child)
-				tmp = tmp->brother;
-			tmp->brother = child->brother;
-		}
+		unlink_child(child);
 		child->parent = NULL;
 	}
 
 	void remove_node(tree_node* node) // delete a node from the node map and the landmark set (if it is in the landmark set)
 	{
-		unsigned int v = node->node_ID;
-		if (node_map.find(node->state) != node_map.end())
+		node_map.erase(node->node_ID, node->state);
+		node_cnt--; // need to modify the node index in the upper layer.
+		if (landmarks.erase((unsigned long long)node->node_ID << 32 | node->state)) // most nodes are not landmarks, the landmark set is unchanged then.
 		{
-			node_map[node->state]->index.erase(node->node_ID);
-			shrink(node_map[node->state]->index);
-			if (node_map[node->state]->index.empty())
-				node_map.erase(node->state);
+			shrink(landmarks);
+			lm_version++;
 		}
-		node_cnt--; // need to modify the node index in the upper layer.
-		landmarks.erase((unsigned long long)node->node_ID << 32 | node->state);
-		shrink(landmarks);
 	}
 	void delete_node(tree_node* node) // delete a node, including separate it from and tree and delete it in the node map
 	{
@@ -218,34 +901,35 @@ public:
 	}
 	void remove_lm(tree_node* node) // delete a landmark.
 	{
-		landmarks.erase(node->node_ID);
-		shrink(landmarks);
+		if (landmarks.erase(node->node_ID))
+		{
+			shrink(landmarks);
+			lm_version++;
+		}
 	}
 	void remove_lm(unsigned long long ID)
 	{
-		landmarks.erase(ID);
-		shrink(landmarks);
+		if (landmarks.erase(ID))
+		{
+			shrink(landmarks);
+			lm_version++;
+		}
 	}
 
 	tree_node* remove_node(unsigned int v, unsigned int state) // given a product graph node, delete its corresponding tree node from the node map and return the tree node pointer.
 	{
-		tree_node* ans = NULL;
-		if (node_map.find(state) != node_map.end())
+		tree_node* ans = node_map.erase(v, state);
+		if (ans)
 		{
-			if (node_map[state]->index.find(v) != node_map[state]->index.end())
+			node_cnt--;
+			if (landmarks.erase((unsigned long long)v << 32 | state))
 			{
-				ans = node_map[state]->index[v];
-				node_map[state]->index.erase(v);
-				node_cnt--;
-				landmarks.erase((unsigned long long)v << 32 | state);
 				shrink(landmarks);
-				shrink(node_map[state]->index);
-				if (node_map[state]->index.empty())
-					node_map.erase(state);
+				lm_version++;
 			}
 		}
 		return ans;
-		
+
 	}
 
 	tree_node* delete_node(unsigned int v, unsigned int state) // given a product graph node, separate its corresponding tree node from the spanning tree and delete it from the nodemap, and return the tree node pointer.
@@ -257,29 +941,13 @@ public:
 
 	void substitute_parent(tree_node* parent, tree_node* child)// change the parent pointer of child to the given parent
 	{
-		if (child->parent->child == child)
-			child->parent->child = child->brother;
-		else
-		{
-			tree_node* tmp = child->parent->child;
-			while (tmp != NULL && tmp->brother != child)
-				tmp = tmp->brother;
-			tmp->brother = child->brother;
-		}
-		child->parent = parent;
-		child->brother = parent->child;
-		parent->child = child;
+		unlink_child(child);
+		link_child(parent, child);
 	}
 
 	tree_node* find_node(unsigned int ID, unsigned int state) // given a product graph node, find its corresponding tree node
 	{
-		tree_node* result = NULL;
-		if (node_map.find(state) != node_map.end())
-		{
-			if (node_map[state]->index.find(ID) != node_map[state]->index.end())
-				result = node_map[state]->index[ID];
-		}
-		return result;
+		return node_map.find(ID, state);
 	}
 
 
@@ -290,259 +958,484 @@ struct tree_info // structure for tree pointer list, used into the reverse map w
 	RPQ_tree* tree;
 	tree_info* next;
 	tree_info* prev;
-	tree_info(RPQ_tree* t = NULL)
+	unsigned int vertex; // vertex ID of the product graph node, and the root of the tree, they form the key of this unit in the info_map.
+	unsigned int root_ID;
+	unsigned int root_state;
+	tree_info(RPQ_tree* t = NULL, unsigned int v = 0, unsigned int root = 0, unsigned int root_state_ = 0)
 	{
 		tree = t;
 		next = NULL;
 		prev = NULL;
+		vertex = v;
+		root_ID = root;
+		root_state = root_state_;
 	}
 };
 
-struct v2t_unit // structure stores a vertex id and a tree_root ID, used to find the tree_info structure in a vertex_to_tree map, namely reverse map between product graph node and normal trees containing it.
+class info_table // open addressing hash table that maps (vertex ID, tree root ID, tree root state) to the tree_info unit, the key is read from the unit. Linear probing and backward shift deletion are used, like edge_index.
 {
-	unsigned int vertex;
-	unsigned int tree_root;
-	v2t_unit(unsigned int v, unsigned int tr)
+public:
+	tree_info** table; // slots of the table, NULL means an empty slot.
+	unsigned int capacity; // number of slots, always a power of 2.
+	unsigned int size; // number of units in the table.
+	info_table()
 	{
-		tree_root = tr;
-		vertex = v;
+		capacity = info_table_min_capacity;
+		size = 0;
+		table = new tree_info * [capacity];
+		for (unsigned int i = 0; i < capacity; i++)
+			table[i] = NULL;
 	}
-};
-
-bool operator<(const v2t_unit& v1, const v2t_unit& v2)
-{
-	if (v1.vertex < v2.vertex)
-		return true;
-	else if (v1.vertex == v2.vertex)
+	~info_table()
 	{
-		if (v1.tree_root < v2.tree_root)
-			return true;
+		delete[] table;
 	}
-	return false;
-}
-
-bool operator==(const v2t_unit& v1, const v2t_unit& v2)
-{
-	if (v1.vertex == v2.vertex && v1.tree_root == v2.tree_root)
-		return true;
-	else
-		return false;
-}
-
-bool operator>(const v2t_unit& v1, const v2t_unit& v2)
-{
-	if (v1.vertex > v2.vertex)
-		return true;
-	else if (v1.vertex == v2.vertex)
+	static unsigned long long hash(unsigned int v, unsigned int root_ID, unsigned int root_state)
 	{
-		if (v1.tree_root > v2.tree_root)
-			return true;
+		unsigned long long h = merge_long_long(v, root_ID) ^ ((unsigned long long)root_state * 0x9E3779B97F4A7C15ULL);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
 	}
-	return false;
-}
-
-struct v2l_unit// structure stores a vertex id and a tree_root ID and a tree_root state, used to find the tree_info structure in a vertex_to_LM map, namely reverse map between product graph node and LM trees containing it.
-	// different from v2t_unit, there is an additional root_state, as the state of root of normal trees is always the initial state 0, but LM trees have different root state;
-{
-	unsigned int vertex;
-	unsigned int root_ID;
-	unsigned int root_state;
-	v2l_unit(unsigned int v, unsigned int tr, unsigned int state)
+	tree_info* find(unsigned int v, unsigned int root_ID, unsigned int root_state) // return the unit with the given key, or NULL if it does not exist.
 	{
-		root_ID = tr;
-		vertex = v;
-		root_state = state;
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(v, root_ID, root_state) & mask;
+		while (table[pos])
+		{
+			tree_info* cur = table[pos];
+			if (cur->vertex == v && cur->root_ID == root_ID && cur->root_state == root_state)
+				return cur;
+			pos = (pos + 1) & mask;
+		}
+		return NULL;
 	}
-};
-
-bool operator<(const v2l_unit& v1, const v2l_unit& v2)
-{
-	if (v1.vertex < v2.vertex)
-		return true;
-	else if (v1.vertex == v2.vertex)
+	void insert(tree_info* unit) // insert a new unit, the caller guarantees that its key is not in the table yet.
 	{
-		if (v1.root_ID < v2.root_ID)
-			return true;
-		else if (v1.root_ID == v2.root_ID && v1.root_state < v2.root_state)
-			return true;
+		if ((size + 1) * 2 > capacity)
+			rehash(capacity * 2);
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(unit->vertex, unit->root_ID, unit->root_state) & mask;
+		while (table[pos])
+			pos = (pos + 1) & mask;
+		table[pos] = unit;
+		size++;
 	}
-	return false;
-}
-
-bool operator==(const v2l_unit& v1, const v2l_unit& v2)
-{
-	if (v1.vertex == v2.vertex && v1.root_ID == v2.root_ID &&v1.root_state == v2.root_state)
-		return true;
-	else
-		return false;
-}
-
-bool operator>(const v2l_unit& v1, const v2l_unit& v2)
-{
-	if (v1.vertex > v2.vertex)
-		return true;
-	else if (v1.vertex == v2.vertex)
+	void erase(tree_info* unit) // delete a unit from the table.
 	{
-		if (v1.root_ID > v2.root_ID)
-			return true;
-		else if (v1.root_ID == v2.root_ID && v1.root_state > v2.root_state)
-			return true;
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(unit->vertex, unit->root_ID, unit->root_state) & mask;
+		while (table[pos] && table[pos] != unit)
+			pos = (pos + 1) & mask;
+		if (!table[pos])
+			return;
+		table[pos] = NULL;
+		size--;
+		unsigned int next = (pos + 1) & mask;
+		while (table[next]) // backward shift, move the following units in the cluster forward if their home slot is not in (pos, next]
+		{
+			unsigned int home = hash(table[next]->vertex, table[next]->root_ID, table[next]->root_state) & mask;
+			if (((next - home) & mask) >= ((next - pos) & mask))
+			{
+				table[pos] = table[next];
+				table[next] = NULL;
+				pos = next;
+			}
+			next = (next + 1) & mask;
+		}
+		if (capacity > info_table_min_capacity && size * 8 < capacity)
+			rehash(capacity / 2);
 	}
-	return false;
-}
+	void rehash(unsigned int new_capacity)
+	{
+		tree_info** old_table = table;
+		unsigned int old_capacity = capacity;
+		capacity = new_capacity;
+		table = new tree_info * [capacity];
+		for (unsigned int i = 0; i < capacity; i++)
+			table[i] = NULL;
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = 0; i < old_capacity; i++)
+		{
+			if (!old_table[i])
+				continue;
+			unsigned int pos = hash(old_table[i]->vertex, old_table[i]->root_ID, old_table[i]->root_state) & mask;
+			while (table[pos])
+				pos = (pos + 1) & mask;
+			table[pos] = old_table[i];
+		}
+		delete[] old_table;
+	}
+	unsigned int compute_memory()
+	{
+		return sizeof(info_table) + capacity * 8;
+	}
+};
 
 class tree_info_index // reverse index from vertex ID to normal trees containing the product graph node. State of the product graph node is given in the upper layer. All product graph nodes in this index have the same state.
 {
 public:
 	unordered_map<unsigned int, tree_info*> tree_index; // map from vertex ID to normal trees
-	map<v2t_unit, tree_info*> info_map; // map from combination of vertex ID and tree root to the tree_info unit, used in deletion to quickly delete a reverse index unit.
+	info_table info_map; // hash table from combination of vertex ID and tree root to the tree_info unit, used in deletion to quickly delete a reverse index unit.
+	free_list_pool<tree_info> info_pool; // memory of the tree_info units
 	tree_info_index() {}
 	~tree_info_index()
 	{
-		for (unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.begin(); iter != tree_index.end(); iter++)
-		{
-			tree_info* cur = iter->second;
-			while (cur)
-			{
-				tree_info* tmp = cur;
-				cur = cur->next;
-				delete tmp;
-			}
-		}
-		tree_index.clear();
-		info_map.clear();
+		tree_index.clear(); // the units are freed with the pool.
 	}
 	void add_node(RPQ_tree* tree_pt, unsigned int v, unsigned int root_ID) // add a normal tree pointer + vertex ID to the reverse index
 	{
-		if (info_map.find(v2t_unit(v, root_ID)) != info_map.end())	// if the combination is already stored.
+		if (info_map.find(v, root_ID, 0))	// if the combination is already stored. The root of a normal tree is always in the initial state 0.
 			return;
-		unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v);
-		if (iter == tree_index.end())
-		{
-			tree_info* cur = new tree_info(tree_pt); //if there is no tree list before, add a new one
-			tree_index[v] = cur;
-			info_map[v2t_unit(v, root_ID)] = cur; // add this unit to the info_map
-		}
-		else
-		{
-			tree_info* cur = new tree_info(tree_pt);// If there is a tree lits, add the new tree_info to the head
-			cur->next = iter->second;
-			iter->second->prev = cur;
-			iter->second = cur;
-			info_map[v2t_unit(v, root_ID)] = cur;
-		}
+		tree_info* cur = new (info_pool.allocate()) tree_info(tree_pt, v, root_ID, 0);
+		tree_info*& head = tree_index[v]; // add the new tree_info to the head of the tree list, the list is created if there is no tree list before.
+		cur->next = head;
+		if (head)
+			head->prev = cur;
+		head = cur;
+		info_map.insert(cur); // add this unit to the info_map
 	}
 
 	void delete_node(unsigned int v, unsigned int root_ID) // delete a tree info unit given the vertex ID -tree root pair, used when a node is deleted from a normal tree.
 	{
-		if (info_map.find(v2t_unit(v, root_ID)) != info_map.end()) // use the info_map to find the unit without scanning the list. 
+		tree_info* cur = info_map.find(v, root_ID, 0); // use the info_map to find the unit without scanning the list. 
+		if (!cur)
+			return;
+		if (cur->prev) // if this unit is not the head of the tree list 
+		{
+			cur->prev->next = cur->next;
+			if (cur->next)
+				cur->next->prev = cur->prev;
+		}
+		else
 		{
-			map<v2t_unit, tree_info*>::iterator iter = info_map.find(v2t_unit(v, root_ID));
-			tree_info* cur = iter->second;
-			if (cur->prev) // if this unit is not the head of the tree list 
+			unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v); // else we need to change the head to the next
+			if (iter != tree_index.end())
 			{
-				cur->prev->next = cur->next;
+				assert(iter->second == cur);
 				if (cur->next)
-					cur->next->prev = cur->prev;
-			}
-			else
-			{
-				unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v); // else we need to change the head to the next
-				if (iter != tree_index.end())
 				{
-					assert(iter->second == cur);
-					if (cur->next)
-					{
-						iter->second = cur->next;
-						cur->next->prev = NULL;
-					}
-					else {
-						tree_index.erase(iter); // if the tree list is empty;
-						shrink(tree_index);
-					}
+					iter->second = cur->next;
+					cur->next->prev = NULL;
+				}
+				else {
+					tree_index.erase(iter); // if the tree list is empty;
+					shrink(tree_index);
 				}
 			}
-			info_map.erase(iter);
-			delete cur;
 		}
+		info_map.erase(cur);
+		info_pool.release(cur);
+	}
+	unsigned int compute_memory() // memory of the info_map and the tree_info units, the tree_index is computed by the caller.
+	{
+		return info_map.compute_memory() + info_pool.compute_memory();
 	}
 };
 
 
-class lm_info_index // similar to the tree_info_index, but is used for LM trees. All the functions are also similar.
+class lm_info_index // similar to the tree_info_index, but is used for LM trees, where the root state is also a part of the key. All the functions are also similar.
 {
 public:
 	unordered_map<unsigned int, tree_info*> tree_index;
-	map<v2l_unit, tree_info*> info_map;
+	info_table info_map;
+	free_list_pool<tree_info> info_pool;
 	lm_info_index() {}
 	~lm_info_index()
 	{
-		for (unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.begin(); iter != tree_index.end(); iter++)
-		{
-			tree_info* cur = iter->second;
-			while (cur)
-			{
-				tree_info* tmp = cur;
-				cur = cur->next;
-				delete tmp;
-			}
-		}
 		tree_index.clear();
-		info_map.clear();
 	}
 	void add_node(RPQ_tree* tree_pt, unsigned int v, unsigned int root_ID, unsigned int root_state)
 	{
-		if (info_map.find(v2l_unit(v, root_ID, root_state)) != info_map.end())
+		if (info_map.find(v, root_ID, root_state))
 			return;
-		unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v);
-		if (iter == tree_index.end())
+		tree_info* cur = new (info_pool.allocate()) tree_info(tree_pt, v, root_ID, root_state);
+		tree_info*& head = tree_index[v];
+		cur->next = head;
+		if (head)
+			head->prev = cur;
+		head = cur;
+		info_map.insert(cur);
+	}
+
+	void delete_node(unsigned int v, unsigned int root_ID, unsigned int root_state)
+	{
+		tree_info* cur = info_map.find(v, root_ID, root_state);
+		if (!cur)
+			return;
+		if (cur->prev)
 		{
-			tree_info* cur = new tree_info(tree_pt);
-			tree_index[v] = cur;
-			info_map[v2l_unit(v, root_ID, root_state)] = cur;
+			cur->prev->next = cur->next;
+			if (cur->next)
+				cur->next->prev = cur->prev;
 		}
 		else
 		{
-			tree_info* cur = new tree_info(tree_pt);
-			cur->next = iter->second;
-			iter->second->prev = cur;
-			iter->second = cur;
-			info_map[v2l_unit(v, root_ID, root_state)] = cur;
+			unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v);
+			if (iter != tree_index.end())
+			{
+				assert(iter->second == cur);
+				if (cur->next)
+				{
+					iter->second = cur->next;
+					cur->next->prev = NULL;
+				}
+				else {
+					tree_index.erase(iter);
+					shrink(tree_index);
+				}
+			}
 		}
+		info_map.erase(cur);
+		info_pool.release(cur);
+	}
+	unsigned int compute_memory()
+	{
+		return info_map.compute_memory() + info_pool.compute_memory();
 	}
+};
 
-	void delete_node(unsigned int v, unsigned int root_ID, unsigned int root_state)
+struct result_entry // slot of the result table, 12 bytes. first is the vertex pair merged into an unsigned long long, 0 marks an empty slot, as a vertex is never paired with itself. second is the largest timestamp of regular paths between the pair.
+{
+	split_key first;
+	unsigned int second;
+};
+
+class result_set // result set of a query, maps each vertex pair (merged into an unsigned long long) to the largest timestamp of regular paths between them.
+	// pairs are stored in an open addressing table with linear probing and backward shift deletion, like edge_index, but the entries are stored in the slots directly.
+	// Besides the table, pairs are also indexed by a calendar queue, whose buckets are aligned to the window slide. Expiration only visits the buckets older than the threshold, instead of scanning the whole result set.
+{
+public:
+	result_entry* table; // slots of the table
+	unsigned int capacity; // number of slots, always a power of 2.
+	unsigned int pair_num; // number of pairs in the table.
+	deque<vector<unsigned long long> > buckets; // buckets[i] stores the pairs whose timestamp falls in bucket first_bucket + i. An entry becomes stale when the timestamp of its pair moves to a later bucket, stale entries are skipped when the bucket expires.
+	unsigned int first_bucket = 0;
+	bool expiring = true; // false if the engine never expires its results, then the pairs are not recorded in the calendar queue.
+	streaming_graph* g = NULL; // the bucket width is read from the window slide of the streaming graph.
+	result_sink* sink = NULL; // if set, each insertion, refresh and expiration of a pair is pushed to the sink. The sink is owned by the caller.
+
+	class iterator // iterates over the occupied slots of the table
 	{
-		if (info_map.find(v2l_unit(v, root_ID, root_state)) != info_map.end())
+	public:
+		result_entry* cur;
+		result_entry* last;
+		iterator(result_entry* cur_, result_entry* last_)
+		{
+			cur = cur_;
+			last = last_;
+			while (cur != last && !cur->first)
+				cur++;
+		}
+		result_entry& operator*() { return *cur; }
+		result_entry* operator->() { return cur; }
+		iterator& operator++()
 		{
-			map<v2l_unit, tree_info*>::iterator iter = info_map.find(v2l_unit(v, root_ID, root_state));
-			tree_info* cur = iter->second;
-			if (cur->prev)
+			cur++;
+			while (cur != last && !cur->first)
+				cur++;
+			return *this;
+		}
+		iterator operator++(int)
+		{
+			iterator old = *this;
+			++(*this);
+			return old;
+		}
+		bool operator!=(const iterator& other) const { return cur != other.cur; }
+		bool operator==(const iterator& other) const { return cur == other.cur; }
+	};
+
+	result_set()
+	{
+		capacity = result_table_min_capacity;
+		pair_num = 0;
+		table = new result_entry[capacity]();
+	}
+	~result_set()
+	{
+		delete[] table;
+	}
+	static unsigned long long hash(unsigned long long pair)
+	{
+		unsigned long long h = pair;
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+	unsigned int bucket_of(unsigned int time)
+	{
+		unsigned int width = (g && g->window_slide > 0) ? g->window_slide : 1;
+		return time / width;
+	}
+	void push(unsigned long long pair, unsigned int time) // record the pair in the bucket of the given time
+	{
+		if (!expiring)
+			return;
+		unsigned int b = bucket_of(time);
+		if (buckets.empty())
+			first_bucket = b;
+		if (b < first_bucket) // timestamp older than the earliest bucket, it will be checked when the earliest bucket expires.
+			b = first_bucket;
+		while (b - first_bucket >= buckets.size())
+			buckets.emplace_back();
+		buckets[b - first_bucket].push_back(pair);
+	}
+	void emit(unsigned char type, unsigned long long pair, unsigned int time) // translate the internal vertex IDs back to the IDs in the stream and push the delta to the sink.
+	{
+		sink->emit(result_delta(type, g->external_id(pair >> 32), g->external_id(pair & 0xFFFFFFFF), time));
+	}
+	result_entry* find(unsigned long long pair) // return the entry of the pair, or NULL if it is not in the result set.
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(pair) & mask;
+		while (table[pos].first)
+		{
+			if (table[pos].first == pair)
+				return &table[pos];
+			pos = (pos + 1) & mask;
+		}
+		return NULL;
+	}
+	bool update(unsigned long long pair, unsigned int time) // keep the larger timestamp of the pair, return true if the pair is new. The slot is found with a single probe sequence, for both insertion and refresh.
+	{
+		if ((pair_num + 1) * 2 > capacity) // keep the load factor under 0.5, so that the probe sequences stay short.
+			rehash(capacity * 2);
+		unsigned int mask = capacity - 1;
+		unsigned int pos = hash(pair) & mask;
+		while (table[pos].first && table[pos].first != pair)
+			pos = (pos + 1) & mask;
+		result_entry& e = table[pos];
+		if (!e.first)
+		{
+			e.first = pair;
+			e.second = time;
+			pair_num++;
+			push(pair, time);
+			if (sink)
+				emit(delta_insert, pair, time);
+			return true;
+		}
+		if (e.second >= time)
+			return false;
+		unsigned int old_bucket = bucket_of(e.second);
+		e.second = time;
+		if (bucket_of(time) != old_bucket) // the pair already has an entry if it stays in the same bucket
+			push(pair, time);
+		if (sink)
+			emit(delta_refresh, pair, time);
+		return false;
+	}
+	void erase(result_entry* e) // delete the pair in the given slot, the table is not shrunk here, as erase is called in batches by expire.
+	{
+		if (sink)
+			emit(delta_expire, e->first, e->second);
+		unsigned int mask = capacity - 1;
+		unsigned int pos = e - table;
+		table[pos].first = 0;
+		pair_num--;
+		unsigned int next = (pos + 1) & mask;
+		while (table[next].first) // backward shift, move the following pairs in the cluster forward if their home slot is not in (pos, next]
+		{
+			unsigned int home = hash(table[next].first) & mask;
+			if (((next - home) & mask) >= ((next - pos) & mask))
 			{
-				cur->prev->next = cur->next;
-				if (cur->next)
-					cur->next->prev = cur->prev;
+				table[pos] = table[next];
+				table[next].first = 0;
+				pos = next;
 			}
-			else
+			next = (next + 1) & mask;
+		}
+	}
+	void rehash(unsigned int new_capacity) // move all the pairs to a new table with the given capacity.
+	{
+		result_entry* old_table = table;
+		unsigned int old_capacity = capacity;
+		capacity = new_capacity;
+		table = new result_entry[capacity]();
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = 0; i < old_capacity; i++)
+		{
+			if (!old_table[i].first)
+				continue;
+			unsigned int pos = hash(old_table[i].first) & mask;
+			while (table[pos].first)
+				pos = (pos + 1) & mask;
+			table[pos] = old_table[i];
+		}
+		delete[] old_table;
+	}
+	void expire(int time_) // delete the pairs with timestamp smaller than the given threshold.
+	{
+		unsigned int time = time_ > 0 ? time_ : 0; // a threshold before the start of the stream expires nothing.
+		while (time > 0 && !buckets.empty() && bucket_of(time) > first_bucket) // the whole bucket is older than the threshold
+		{
+			vector<unsigned long long>& bucket = buckets.front();
+			for (unsigned int i = 0; i < bucket.size(); i++)
 			{
-				unordered_map<unsigned int, tree_info*>::iterator iter = tree_index.find(v);
-				if (iter != tree_index.end())
-				{
-					assert(iter->second == cur);
-					if (cur->next)
-					{
-						iter->second = cur->next;
-						cur->next->prev = NULL;
-					}
-					else {
-						tree_index.erase(iter);
-						shrink(tree_index);
-					}
-				}
+				result_entry* e = find(bucket[i]);
+				if (e && e->second < time)
+					erase(e);
+			}
+			buckets.pop_front();
+			first_bucket++;
+		}
+		if (time > 0 && !buckets.empty() && bucket_of(time) == first_bucket) // the threshold falls inside the earliest bucket, check its pairs one by one, and drop the stale entries at the same time.
+		{
+			vector<unsigned long long>& bucket = buckets.front();
+			unsigned int kept = 0;
+			for (unsigned int i = 0; i < bucket.size(); i++)
+			{
+				result_entry* e = find(bucket[i]);
+				if (!e)
+					continue;
+				if (e->second < time)
+					erase(e);
+				else if (bucket_of(e->second) <= first_bucket)
+					bucket[kept++] = bucket[i];
 			}
-			info_map.erase(iter);
-			delete cur;
+			bucket.resize(kept);
 		}
+		unsigned int new_capacity = capacity;
+		while (new_capacity > result_table_min_capacity && pair_num * 8 < new_capacity) // shrink the table if it becomes too sparse after the expiration.
+			new_capacity /= 2;
+		if (new_capacity != capacity)
+			rehash(new_capacity);
+		if (sink)
+			sink->flush(); // end of a slide
+	}
+	iterator begin()
+	{
+		return iterator(table, table + capacity);
+	}
+	iterator end()
+	{
+		return iterator(table + capacity, table + capacity);
+	}
+	size_t size()
+	{
+		return pair_num;
+	}
+	void clear()
+	{
+		delete[] table;
+		capacity = result_table_min_capacity;
+		pair_num = 0;
+		table = new result_entry[capacity]();
+		buckets.clear();
+	}
+	unsigned int compute_memory() // memory of the table and the calendar queue
+	{
+		unsigned int memory = sizeof(result_set) + capacity * sizeof(result_entry);
+		for (unsigned int i = 0; i < buckets.size(); i++)
+			memory += sizeof(vector<unsigned long long>) + buckets[i].capacity() * sizeof(unsigned long long);
+		return memory;
 	}
 };
 
@@ -746,6 +1639,22 @@ public:
 		return false;
 	}
 
+	pg_edge* successor_list(unsigned int src, unsigned int src_state) // head of the out edge list of (src, src_state), the successors can be scanned in place with src_next, without copying them into a vector.
+	{
+		unordered_map<unsigned long long, pg_node>::iterator it = g.find(merge_long_long(src, src_state));
+		if (it != g.end())
+			return it->second.src_list;
+		return NULL;
+	}
+
+	pg_edge* precursor_list(unsigned int dst, unsigned int dst_state) // head of the in edge list of (dst, dst_state), scanned with dst_next.
+	{
+		unordered_map<unsigned long long, pg_node>::iterator it = g.find(merge_long_long(dst, dst_state));
+		if (it != g.end())
+			return it->second.dst_list;
+		return NULL;
+	}
+
 	void get_successor(unsigned int src, unsigned int src_state, vector < pair<unsigned long long, unsigned int>>& suc)
 	{
 		unsigned long long src_info = merge_long_long(src, src_state);
@@ -0,0 +1,106 @@
+#pragma once
+#include<string>
+#include<unordered_set>
+#include<atomic>
+#include<thread>
+#include "edge_stream.h"
+#include "spsc_queue.h"
+#include "automaton.h"
+using namespace std;
+
+// ingest stage that runs on its own thread. It reads (parses or decodes) the edge stream, drops the edges whose label is not accepted by the automaton,
+// and passes the remaining edges to the engine thread through a bounded lock-free queue. The engine thread only pays for the edges that can be part of a result.
+
+struct stream_edge
+{
+	unsigned int s;
+	unsigned int d;
+	unsigned int l;
+	unsigned long long t;
+};
+
+class ingest_pipeline
+{
+public:
+	edge_stream fin;
+	spsc_queue<stream_edge> queue;
+	unordered_set<unsigned int> labels; // copy of the acceptable labels of the automaton, owned by the producer thread
+	unsigned int slide; // the slide of the window, in the time unit of the stream
+	atomic<bool> finished; // set by the producer after the last edge is pushed
+	atomic<bool> stop; // set by the destructor, the producer then quits without reading the rest of the stream
+	atomic<unsigned long long> read_num; // number of edges read from the stream
+	atomic<unsigned long long> dropped_num; // number of edges dropped by the label filter
+	thread producer;
+
+	ingest_pipeline(const string& path, automaton* aut, unsigned int slide_, unsigned int capacity = 65536) : fin(path), queue(capacity)
+	{
+		labels = aut->acceptable_labels;
+		slide = slide_;
+		finished.store(false);
+		stop.store(false);
+		read_num.store(0);
+		dropped_num.store(0);
+		producer = thread(&ingest_pipeline::produce, this);
+	}
+	~ingest_pipeline() // the engine thread may stop reading before the end of the stream, thus the producer is told to quit instead of waiting on the full queue.
+	{
+		stop.store(true, memory_order_release);
+		if (producer.joinable())
+			producer.join();
+	}
+	void produce()
+		// an edge with an unacceptable label is still passed on if it would make the engine thread slide the window, as the demo expires the window when the first edge of a new slice arrives,
+		// and the window should slide at the same edges as without the filter. Such an edge is ignored by insert_edge of the engines.
+	{
+		stream_edge e;
+		unsigned long long t0 = 0;
+		unsigned int slice = 0; // follows the slice counter of the engine thread
+		unsigned long long n = 0;
+		unsigned long long dropped = 0;
+		while (!stop.load(memory_order_acquire) && fin.next(e.s, e.d, e.l, e.t))
+		{
+			n++;
+			if ((n & 0xFFFF) == 0) // publish the statistics from time to time
+			{
+				read_num.store(n, memory_order_relaxed);
+				dropped_num.store(dropped, memory_order_relaxed);
+			}
+			bool first = (t0 == 0); // the first edge is always passed on, as the engine thread takes its timestamp as the start of the stream
+			if (first)
+				t0 = e.t;
+			unsigned int time = e.t - t0 + 1;
+			bool slides = (slide > 0 && time / slide > slice);
+			if (slides)
+				slice++;
+			else if (!first && labels.find(e.l) == labels.end())
+			{
+				dropped++;
+				continue;
+			}
+			if (!queue.push(e, stop))
+				break;
+		}
+		read_num.store(n, memory_order_relaxed);
+		dropped_num.store(dropped, memory_order_relaxed);
+		finished.store(true, memory_order_release);
+	}
+	bool next(unsigned int& s, unsigned int& d, unsigned int& l, unsigned long long& t) // called by the engine thread, waits for the producer if the queue is empty, returns false at the end of the stream.
+	{
+		stream_edge e;
+		while (!queue.pop(e))
+		{
+			if (finished.load(memory_order_acquire))
+			{
+				if (!queue.pop(e)) // edges pushed before finished was set
+					return false;
+				break;
+			}
+			this_thread::yield();
+		}
+		s = e.s;
+		d = e.d;
+		l = e.l;
+		t = e.t;
+		return true;
+	}
+};
@@ -0,0 +1,459 @@
+#pragma once
+#include<iostream>
+#include<map>
+#include<unordered_set>
+#include<vector>
+#include<string>
+#include<algorithm>
+#include "automaton.h"
+using namespace std;
+
+// this file compiles a regular expression over edge labels into a minimized DFA. The expression is first translated into an NFA with Thompson construction, then into a DFA with subset construction,
+// and the DFA is minimized with Hopcroft's algorithm. The depth scores of the states used by the landmark selection (aut_scores) are also derived from the DFA.
+// syntax: labels are non-negative integers, concatenation is written by juxtaposition, with labels separated by spaces or '.', alternation is '|', and '*', '+', '?' are the postfix
+// operators meaning zero or more, one or more, and zero or one. Parentheses can be used for grouping. For example, Q7 (a1+a2+a3)b* in the paper is written as "(1|2|3) 4*".
+
+#define loop_depth 6 // estimated depth contributed by a loop in the DFA, it is the value used in the hand-tuned scores of the demo queries.
+
+struct nfa_edge
+{
+	int dst;
+	int label; // -1 means an epsilon edge
+	nfa_edge(int dst_, int label_)
+	{
+		dst = dst_;
+		label = label_;
+	}
+};
+
+class regex_compiler
+{
+public:
+	string expr; // the regular expression being parsed
+	unsigned int pos; // current position of the parser
+	string error_msg; // reason of the failure if compile returns false
+	vector<vector<nfa_edge> > nfa; // out edges of each NFA state
+	vector<map<int, int> > dfa; // transitions of each DFA state, from a label to the dst state. After compile, it stores the minimized DFA, with 0 as the initial state
+	vector<bool> dfa_final; // whether a DFA state is a final state
+	vector<unsigned int> scores; // estimated depth of the spanning tree below each state, used as aut_scores in LM-SRPQ and its variants
+	unsigned int state_num; // number of states in the minimized DFA
+
+	regex_compiler()
+	{
+		pos = 0;
+		state_num = 0;
+	}
+
+	bool compile(const string& regex, automaton* aut) // compile the regular expression, and write the minimized DFA into aut, which should be an empty automaton. Return false if the expression can not be parsed.
+	{
+		expr = regex;
+		pos = 0;
+		error_msg.clear();
+		nfa.clear();
+		pair<int, int> frag;
+		if (!parse_alternation(frag))
+			return false;
+		skip_separators();
+		if (pos < expr.size())
+			return fail("unexpected character");
+		subset_construction(frag.first, frag.second);
+		minimize();
+		compute_scores();
+		aut->final_state.clear(); // the automaton sets state 0 as a final state by default, the final states are decided by the expression here.
+		for (unsigned int s = 0; s < dfa.size(); s++)
+		{
+			if (dfa_final[s])
+				aut->set_final_state(s);
+			for (map<int, int>::iterator it = dfa[s].begin(); it != dfa[s].end(); it++)
+				aut->insert_edge(s, it->second, it->first);
+		}
+		state_num = dfa.size();
+		return true;
+	}
+
+	bool fail(const string& msg)
+	{
+		error_msg = msg + " at position " + to_string(pos) + " of \"" + expr + "\"";
+		return false;
+	}
+
+	int new_state()
+	{
+		nfa.push_back(vector<nfa_edge>());
+		return nfa.size() - 1;
+	}
+
+	void skip_separators()
+	{
+		while (pos < expr.size() && (expr[pos] == ' ' || expr[pos] == '.' || expr[pos] == '\t'))
+			pos++;
+	}
+
+	// recursive descent parser, each function builds an NFA fragment and returns its start and end state.
+	bool parse_alternation(pair<int, int>& frag) // alternation := concatenation ('|' concatenation)*
+	{
+		if (!parse_concatenation(frag))
+			return false;
+		skip_separators();
+		while (pos < expr.size() && expr[pos] == '|')
+		{
+			pos++;
+			pair<int, int> right;
+			if (!parse_concatenation(right))
+				return false;
+			int s = new_state();
+			int e = new_state();
+			nfa[s].push_back(nfa_edge(frag.first, -1));
+			nfa[s].push_back(nfa_edge(right.first, -1));
+			nfa[frag.second].push_back(nfa_edge(e, -1));
+			nfa[right.second].push_back(nfa_edge(e, -1));
+			frag = make_pair(s, e);
+			skip_separators();
+		}
+		return true;
+	}
+
+	bool parse_concatenation(pair<int, int>& frag) // concatenation := repetition+
+	{
+		if (!parse_repetition(frag))
+			return false;
+		while (true)
+		{
+			skip_separators();
+			if (pos >= expr.size() || expr[pos] == '|' || expr[pos] == ')')
+				return true;
+			pair<int, int> right;
+			if (!parse_repetition(right))
+				return false;
+			nfa[frag.second].push_back(nfa_edge(right.first, -1));
+			frag.second = right.second;
+		}
+	}
+
+	bool parse_repetition(pair<int, int>& frag) // repetition := atom ('*' | '+' | '?')*
+	{
+		if (!parse_atom(frag))
+			return false;
+		while (true)
+		{
+			skip_separators();
+			if (pos >= expr.size() || (expr[pos] != '*' && expr[pos] != '+' && expr[pos] != '?'))
+				return true;
+			char op = expr[pos++];
+			int s = new_state();
+			int e = new_state();
+			nfa[s].push_back(nfa_edge(frag.first, -1));
+			nfa[frag.second].push_back(nfa_edge(e, -1));
+			if (op != '+') // the fragment can be skipped
+				nfa[s].push_back(nfa_edge(e, -1));
+			if (op != '?') // the fragment can be repeated
+				nfa[frag.second].push_back(nfa_edge(frag.first, -1));
+			frag = make_pair(s, e);
+		}
+	}
+
+	bool parse_atom(pair<int, int>& frag) // atom := label | '(' alternation ')'
+	{
+		skip_separators();
+		if (pos >= expr.size())
+			return fail("unexpected end of expression");
+		if (expr[pos] == '(')
+		{
+			pos++;
+			if (!parse_alternation(frag))
+				return false;
+			skip_separators();
+			if (pos >= expr.size() || expr[pos] != ')')
+				return fail("missing ')'");
+			pos++;
+			return true;
+		}
+		if (expr[pos] < '0' || expr[pos] > '9')
+			return fail("expect a label");
+		long long label = 0;
+		while (pos < expr.size() && expr[pos] >= '0' && expr[pos] <= '9')
+		{
+			label = label * 10 + (expr[pos++] - '0');
+			if (label > 0x7FFFFFFF)
+				return fail("label out of range");
+		}
+		int s = new_state();
+		int e = new_state();
+		nfa[s].push_back(nfa_edge(e, (int)label));
+		frag = make_pair(s, e);
+		return true;
+	}
+
+	void closure(vector<int>& states) // extend a set of NFA states with the states reachable through epsilon edges, the result is sorted.
+	{
+		vector<bool> visited(nfa.size(), false);
+		vector<int> stack = states;
+		states.clear();
+		while (!stack.empty())
+		{
+			int s = stack.back();
+			stack.pop_back();
+			if (visited[s])
+				continue;
+			visited[s] = true;
+			states.push_back(s);
+			for (unsigned int i = 0; i < nfa[s].size(); i++)
+			{
+				if (nfa[s][i].label == -1 && !visited[nfa[s][i].dst])
+					stack.push_back(nfa[s][i].dst);
+			}
+		}
+		sort(states.begin(), states.end());
+	}
+
+	void subset_construction(int start, int final) // build the DFA whose states are the sets of NFA states reachable with the same input.
+	{
+		dfa.clear();
+		dfa_final.clear();
+		map<vector<int>, int> ids;
+		vector<vector<int> > sets;
+		vector<int> init(1, start);
+		closure(init);
+		ids[init] = 0;
+		sets.push_back(init);
+		for (unsigned int cur = 0; cur < sets.size(); cur++)
+		{
+			dfa.push_back(map<int, int>());
+			dfa_final.push_back(binary_search(sets[cur].begin(), sets[cur].end(), final));
+			map<int, vector<int> > moves; // label -> NFA states reached by this label
+			for (unsigned int i = 0; i < sets[cur].size(); i++)
+			{
+				vector<nfa_edge>& edges = nfa[sets[cur][i]];
+				for (unsigned int j = 0; j < edges.size(); j++)
+				{
+					if (edges[j].label != -1)
+						moves[edges[j].label].push_back(edges[j].dst);
+				}
+			}
+			for (map<int, vector<int> >::iterator it = moves.begin(); it != moves.end(); it++)
+			{
+				vector<int> next = it->second;
+				closure(next);
+				map<vector<int>, int>::iterator id = ids.find(next);
+				if (id == ids.end())
+				{
+					id = ids.insert(make_pair(next, sets.size())).first;
+					sets.push_back(next);
+				}
+				dfa[cur][it->first] = id->second;
+			}
+		}
+	}
+
+	void minimize() // Hopcroft's algorithm. The DFA is completed with a dead state, states are partitioned into classes of equivalent states, and each class becomes a state of the minimized DFA.
+	{
+		vector<int> labels;
+		for (unsigned int s = 0; s < dfa.size(); s++)
+		{
+			for (map<int, int>::iterator it = dfa[s].begin(); it != dfa[s].end(); it++)
+				labels.push_back(it->first);
+		}
+		sort(labels.begin(), labels.end());
+		labels.erase(unique(labels.begin(), labels.end()), labels.end());
+		int n = dfa.size() + 1; // the last state is the dead state
+		int dead = n - 1;
+		vector<vector<vector<int> > > inv(labels.size(), vector<vector<int> >(n)); // inv[l][t] stores the states which move to t with the l-th label
+		for (int s = 0; s < n; s++)
+		{
+			for (unsigned int l = 0; l < labels.size(); l++)
+			{
+				int t = dead;
+				if (s != dead)
+				{
+					map<int, int>::iterator it = dfa[s].find(labels[l]);
+					if (it != dfa[s].end())
+						t = it->second;
+				}
+				inv[l][t].push_back(s);
+			}
+		}
+
+		vector<int> cls(n); // class of each state
+		vector<vector<int> > classes;
+		vector<int> finals, others;
+		for (int s = 0; s < n; s++)
+		{
+			if (s != dead && dfa_final[s])
+				finals.push_back(s);
+			else
+				others.push_back(s);
+		}
+		if (!finals.empty())
+			classes.push_back(finals);
+		classes.push_back(others); // others is never empty as it has the dead state
+		for (unsigned int c = 0; c < classes.size(); c++)
+		{
+			for (unsigned int i = 0; i < classes[c].size(); i++)
+				cls[classes[c][i]] = c;
+		}
+		vector<int> work; // classes waiting to be used as splitters
+		vector<bool> in_work;
+		for (unsigned int c = 0; c < classes.size(); c++)
+		{
+			work.push_back(c);
+			in_work.push_back(true);
+		}
+		while (!work.empty())
+		{
+			int a = work.back();
+			work.pop_back();
+			in_work[a] = false;
+			vector<int> splitter = classes[a]; // a copy, as class a itself may be split by one label, and the remaining labels must still use the whole splitter.
+			for (unsigned int l = 0; l < labels.size(); l++)
+			{
+				vector<bool> marked(n, false); // states moving into the splitter with the l-th label
+				map<int, vector<int> > touched; // class -> its marked states
+				for (unsigned int i = 0; i < splitter.size(); i++)
+				{
+					vector<int>& pre = inv[l][splitter[i]];
+					for (unsigned int j = 0; j < pre.size(); j++)
+					{
+						if (!marked[pre[j]])
+						{
+							marked[pre[j]] = true;
+							touched[cls[pre[j]]].push_back(pre[j]);
+						}
+					}
+				}
+				for (map<int, vector<int> >::iterator it = touched.begin(); it != touched.end(); it++)
+				{
+					int y = it->first;
+					if (it->second.size() == classes[y].size()) // all the states of the class are marked, no split
+						continue;
+					vector<int> rest;
+					for (unsigned int i = 0; i < classes[y].size(); i++)
+					{
+						if (!marked[classes[y][i]])
+							rest.push_back(classes[y][i]);
+					}
+					int z = classes.size(); // the marked states stay in class y, and the others move to the new class z
+					classes[y] = it->second;
+					classes.push_back(rest);
+					in_work.push_back(false);
+					for (unsigned int i = 0; i < rest.size(); i++)
+						cls[rest[i]] = z;
+					if (in_work[y])
+					{
+						work.push_back(z);
+						in_work[z] = true;
+					}
+					else
+					{
+						int smaller = classes[y].size() <= classes[z].size() ? y : z;
+						work.push_back(smaller);
+						in_work[smaller] = true;
+					}
+				}
+			}
+		}
+
+		// build the minimized DFA, the class of the dead state is dropped, and the classes are numbered in BFS order from the initial state.
+		int dead_class = cls[dead];
+		vector<int> id(classes.size(), -1);
+		vector<int> order;
+		id[cls[0]] = 0;
+		order.push_back(cls[0]);
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			int rep = classes[order[i]][0];
+			for (map<int, int>::iterator it = dfa[rep].begin(); it != dfa[rep].end(); it++)
+			{
+				int c = cls[it->second];
+				if (c != dead_class && id[c] == -1)
+				{
+					id[c] = order.size();
+					order.push_back(c);
+				}
+			}
+		}
+		vector<map<int, int> > min_dfa(order.size());
+		vector<bool> min_final(order.size());
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			int rep = classes[order[i]][0];
+			min_final[i] = dfa_final[rep];
+			for (map<int, int>::iterator it = dfa[rep].begin(); it != dfa[rep].end(); it++)
+			{
+				int c = cls[it->second];
+				if (c != dead_class)
+					min_dfa[i][it->first] = id[c];
+			}
+		}
+		dfa = min_dfa;
+		dfa_final = min_final;
+	}
+
+	void compute_scores() // a state in a loop adds loop_depth to the depth, and an edge to a state out of the loop adds 1 plus the depth of that state. The initial state gets 0 if it has no incoming edge, as it only appears as roots.
+	{
+		int n = dfa.size();
+		vector<vector<bool> > reach(n, vector<bool>(n, false)); // reach[i][j] means j can be reached from i with at least one edge
+		for (int s = 0; s < n; s++)
+		{
+			for (map<int, int>::iterator it = dfa[s].begin(); it != dfa[s].end(); it++)
+				reach[s][it->second] = true;
+		}
+		for (int k = 0; k < n; k++)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				if (!reach[i][k])
+					continue;
+				for (int j = 0; j < n; j++)
+				{
+					if (reach[k][j])
+						reach[i][j] = true;
+				}
+			}
+		}
+		scores.assign(n, 0);
+		vector<bool> done(n, false);
+		for (int s = 0; s < n; s++)
+			score_of(s, reach, done);
+		bool has_incoming = false;
+		for (int s = 0; s < n; s++)
+		{
+			for (map<int, int>::iterator it = dfa[s].begin(); it != dfa[s].end(); it++)
+			{
+				if (it->second == 0)
+					has_incoming = true;
+			}
+		}
+		if (!has_incoming)
+			scores[0] = 0;
+	}
+
+	unsigned int score_of(int s, vector<vector<bool> >& reach, vector<bool>& done) // states in the same strongly connected component share the score, computed over all the edges leaving the component.
+	{
+		if (done[s])
+			return scores[s];
+		int n = dfa.size();
+		unsigned int best = 0;
+		for (int u = 0; u < n; u++)
+		{
+			if (u != s && !(reach[s][u] && reach[u][s]))
+				continue;
+			for (map<int, int>::iterator it = dfa[u].begin(); it != dfa[u].end(); it++)
+			{
+				int t = it->second;
+				if (reach[t][s]) // t is in the same component
+					continue;
+				best = max(best, 1 + score_of(t, reach, done));
+			}
+		}
+		unsigned int score = best + (reach[s][s] ? loop_depth : 0);
+		for (int u = 0; u < n; u++)
+		{
+			if (u == s || (reach[s][u] && reach[u][s]))
+			{
+				scores[u] = score;
+				done[u] = true;
+			}
+		}
+		return score;
+	}
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include<iostream>
+#include<fstream>
+#include<string>
+#include<vector>
+#include<functional>
+#include "spsc_queue.h"
+#define delta_insert 0 // a vertex pair enters the result set
+#define delta_refresh 1 // the largest path timestamp of a vertex pair in the result set becomes larger
+#define delta_expire 2 // a vertex pair leaves the result set as all its paths expire
+using namespace std;
+
+// this file defines the sinks that receive the changes of the result set. The result set pushes a delta to its sink whenever a pair is inserted, refreshed or expired,
+// thus downstream consumers can follow the query answer continuously, without scanning the result set.
+
+struct result_delta
+{
+	unsigned char type; // delta_insert, delta_refresh or delta_expire
+	unsigned int src; // vertex IDs in the stream
+	unsigned int dst;
+	unsigned int timestamp; // new timestamp of the pair, or the timestamp it has when it expires
+	result_delta(unsigned char type_ = 0, unsigned int src_ = 0, unsigned int dst_ = 0, unsigned int timestamp_ = 0)
+	{
+		type = type_;
+		src = src_;
+		dst = dst_;
+		timestamp = timestamp_;
+	}
+};
+
+class result_sink // base class of the sinks. emit is called for each delta, flush is called at the end of each expiration, namely once per slide.
+{
+public:
+	virtual ~result_sink() {}
+	virtual void emit(const result_delta& delta) = 0;
+	virtual void flush() {}
+};
+
+class callback_sink : public result_sink // calls a user function for each delta, and another one (if given) at the end of each slide.
+{
+public:
+	function<void(const result_delta&)> on_delta;
+	function<void()> on_slide;
+	callback_sink(function<void(const result_delta&)> on_delta_, function<void()> on_slide_ = nullptr)
+	{
+		on_delta = on_delta_;
+		on_slide = on_slide_;
+	}
+	void emit(const result_delta& delta)
+	{
+		on_delta(delta);
+	}
+	void flush()
+	{
+		if (on_slide)
+			on_slide();
+	}
+};
+
+class ring_buffer_sink : public result_sink // lock-free single producer single consumer ring buffer. The query thread produces the deltas, and another thread consumes them with pop.
+{
+public:
+	spsc_queue<result_delta> queue;
+	ring_buffer_sink(unsigned int capacity = 65536) : queue(capacity) {}
+	void emit(const result_delta& delta) // the producer waits for the consumer if the buffer is full, no delta is dropped.
+	{
+		queue.push(delta);
+	}
+	bool pop(result_delta& delta) // called by the consumer, returns false if the buffer is empty.
+	{
+		return queue.pop(delta);
+	}
+	unsigned long long pending()
+	{
+		return queue.pending();
+	}
+};
+
+class file_sink : public result_sink // appends the deltas to a binary file. Each delta is a 13 byte record: type (1 byte), src, dst and timestamp (4 bytes each, little endian on common platforms).
+{
+public:
+	ofstream fout;
+	file_sink(const string& file_name)
+	{
+		fout.open(file_name.c_str(), ios::binary | ios::app);
+	}
+	~file_sink()
+	{
+		fout.close();
+	}
+	void emit(const result_delta& delta)
+	{
+		fout.write((const char*)&delta.type, 1);
+		fout.write((const char*)&delta.src, 4);
+		fout.write((const char*)&delta.dst, 4);
+		fout.write((const char*)&delta.timestamp, 4);
+	}
+	void flush()
+	{
+		fout.flush(); // deltas of a slide become visible to readers of the file at the end of the slide
+	}
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include<vector>
+#include<atomic>
+#include<thread>
+#include<chrono>
+using namespace std;
+
+// bounded lock-free queue between one producer thread and one consumer thread, used to pass edges to the engine and result deltas out of it.
+// Each side keeps a private copy of the other side's position and only reloads the shared one when the copy says the queue is full (or empty),
+// thus the two threads rarely touch the same cache line.
+
+template <class T>
+class spsc_queue
+{
+public:
+	vector<T> slots;
+	unsigned long long mask; // capacity is a power of 2, positions are taken modulo the capacity with this mask
+	atomic<unsigned long long> head; // next position to read, only written by the consumer
+	char pad1[64]; // keep head and tail on different cache lines
+	atomic<unsigned long long> tail; // next position to write, only written by the producer
+	char pad2[64];
+	unsigned long long head_cache; // the producer's copy of head
+	char pad3[64];
+	unsigned long long tail_cache; // the consumer's copy of tail
+
+	spsc_queue(unsigned int capacity = 65536)
+	{
+		unsigned int c = 1;
+		while (c < capacity)
+			c <<= 1;
+		slots.resize(c);
+		mask = c - 1;
+		head.store(0);
+		tail.store(0);
+		head_cache = 0;
+		tail_cache = 0;
+	}
+	bool try_push(const T& item) // called by the producer, returns false if the queue is full.
+	{
+		unsigned long long t = tail.load(memory_order_relaxed);
+		if (t - head_cache > mask)
+		{
+			head_cache = head.load(memory_order_acquire);
+			if (t - head_cache > mask)
+				return false;
+		}
+		slots[t & mask] = item;
+		tail.store(t + 1, memory_order_release);
+		return true;
+	}
+	void push(const T& item) // called by the producer, waits for the consumer if the queue is full. The producer sleeps instead of spinning, as it is usually ahead of the consumer.
+	{
+		while (!try_push(item))
+			this_thread::sleep_for(chrono::microseconds(50));
+	}
+	bool push(const T& item, const atomic<bool>& stop) // like push, but gives up and returns false once stop is set, so that a producer waiting on a full queue can be shut down.
+	{
+		while (!try_push(item))
+		{
+			if (stop.load(memory_order_acquire))
+				return false;
+			this_thread::sleep_for(chrono::microseconds(50));
+		}
+		return true;
+	}
+	bool pop(T& item) // called by the consumer, returns false if the queue is empty.
+	{
+		unsigned long long h = head.load(memory_order_relaxed);
+		if (h == tail_cache)
+		{
+			tail_cache = tail.load(memory_order_acquire);
+			if (h == tail_cache)
+				return false;
+		}
+		item = slots[h & mask];
+		head.store(h + 1, memory_order_release);
+		return true;
+	}
+	unsigned long long pending()
+	{
+		return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+	}
+};
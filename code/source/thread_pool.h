@@ -0,0 +1,105 @@
+#pragma once
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<functional>
+using namespace std;
+
+// fixed set of worker threads that run the iterations of parallel loops, used by the landmark selection of LM-SRPQ to score product graph nodes and to preview the benefit of landmarks.
+// The threads are created once and wait between loops, as a loop is started at every window slide. The calling thread works on the loop as well, thus a pool of size 1 has no worker thread and runs the loop inline.
+
+class thread_pool
+{
+public:
+	vector<thread> workers;
+	mutex m;
+	condition_variable start_cv; // signals the workers that a new loop starts, or that the pool is destroyed
+	condition_variable done_cv; // signals the calling thread that the last worker has left the loop
+	const function<void(unsigned int)>* job = NULL; // body of the current loop, called with the iteration index
+	atomic<unsigned int> next; // next iteration to take
+	unsigned int end = 0; // number of iterations of the current loop
+	unsigned long long generation = 0; // increased for each loop, so that a worker joins each loop once
+	unsigned int running = 0; // number of workers in the current loop
+	bool stopping = false;
+
+	thread_pool(unsigned int size = 0) // size is the number of threads including the calling thread, 0 means the number of hardware threads.
+	{
+		if (size == 0)
+			size = thread::hardware_concurrency();
+		if (size == 0)
+			size = 1;
+		next.store(0);
+		for (unsigned int i = 1; i < size; i++)
+			workers.push_back(thread(&thread_pool::work, this));
+	}
+	~thread_pool()
+	{
+		{
+			lock_guard<mutex> lock(m);
+			stopping = true;
+		}
+		start_cv.notify_all();
+		for (unsigned int i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+	unsigned int size()
+	{
+		return workers.size() + 1;
+	}
+	void run_iterations(const function<void(unsigned int)>& f) // take iterations from the shared counter until there is none left
+	{
+		unsigned int i;
+		while ((i = next.fetch_add(1)) < end)
+			f(i);
+	}
+	void work()
+	{
+		unsigned long long seen = 0;
+		while (true)
+		{
+			const function<void(unsigned int)>* f;
+			{
+				unique_lock<mutex> lock(m);
+				start_cv.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+				f = job;
+				if (!f) // woke up after the loop has finished
+					continue;
+				running++;
+			}
+			run_iterations(*f);
+			{
+				lock_guard<mutex> lock(m);
+				running--;
+			}
+			done_cv.notify_one();
+		}
+	}
+	void parallel_for(unsigned int n, const function<void(unsigned int)>& f) // run f(0), ..., f(n - 1) on the pool and return when all of them are finished. f should only read the shared structures, or write to the slots of its own iteration.
+	{
+		if (n == 0)
+			return;
+		if (workers.empty() || n == 1)
+		{
+			for (unsigned int i = 0; i < n; i++)
+				f(i);
+			return;
+		}
+		{
+			lock_guard<mutex> lock(m);
+			job = &f;
+			end = n;
+			next.store(0);
+			generation++;
+		}
+		start_cv.notify_all();
+		run_iterations(f);
+		unique_lock<mutex> lock(m);
+		done_cv.wait(lock, [&] { return running == 0; }); // the iterations are all taken, wait for the workers still running theirs
+		job = NULL;
+	}
+};